@@ -0,0 +1,308 @@
+/// \file       bench/bench.cpp
+/// \copyright  2022 Thomas E. Vaughan.  See terms in LICENSE.
+/// \brief      End-to-end benchmark of dirichlet::Fill, dirichlet::FillBiLin,
+///             and regfill::image::laplacian_fill().
+///
+/// Every combination of engine, type of pixel, size of image, number of
+/// holes, and radius of hole runs in its own child-process, so that peak
+/// resident memory belongs to that combination alone and so that crash of one
+/// engine does not end run.  Each combination writes one line of JSON to
+/// standard output.
+///
+/// Usage: `bench [repetitions]`, where repetitions (default 5) is number of
+/// solutions timed after construction.
+
+#include "dirichlet/Fill.hpp"      // Fill
+#include "dirichlet/FillBiLin.hpp" // FillBiLin
+#include "regfill/image.hpp"       // image
+#include <algorithm>               // count_if
+#include <chrono>                  // steady_clock
+#include <cmath>                   // sin, cos
+#include <cstdint>                 // uint8_t, uint16_t
+#include <cstdio>                  // printf, fflush
+#include <cstdlib>                 // atoi, rand, srand
+#include <string>                  // string
+#include <sys/resource.h>          // getrusage
+#include <sys/wait.h>              // waitpid
+#include <unistd.h>                // fork, _exit
+#include <vector>                  // vector
+
+using std::string;
+using std::vector;
+
+
+/// Engine to benchmark.
+enum Engine { FILL_CHOLESKY, FILL_CG, FILL_SCHUR, FILL_BILIN, REGFILL };
+
+
+/// Type of pixel.
+enum Pixel { U8, U16, F32 };
+
+
+/// Name of engine, as written in output.
+char const *const engineName[]= {
+      "fill-cholesky", "fill-cg", "fill-schur", "fillbilin", "regfill"};
+
+
+/// Name of type of pixel, as written in output.
+char const *const pixelName[]= {"u8", "u16", "f32"};
+
+
+/// One combination of parameters.
+struct Config {
+  Engine engine; ///< Engine.
+  Pixel  pixel;  ///< Type of pixel.
+  int    size;   ///< Number of rows and of columns in image.
+  int    holes;  ///< Number of holes, on square grid.
+  int    radius; ///< Radius of each hole, in pixels.
+};
+
+
+/// Measurements for one combination.
+struct Result {
+  int    filled   = 0; ///< Number of filled pixels.
+  double construct= 0; ///< Seconds to construct, or zero for regfill.
+  double solve    = 0; ///< Mean seconds per solution.
+  int    iters    = 0; ///< Iterations in last solution, if iterative.
+};
+
+
+/// Seconds since arbitrary epoch.
+/// \return  Seconds since arbitrary epoch.
+double now() {
+  using namespace std::chrono;
+  return duration<double>(steady_clock::now().time_since_epoch()).count();
+}
+
+
+/// Make mask with holes, each a disk, centered on cells of square grid.
+/// \param c  Combination of parameters.
+/// \return   Row-major mask, one byte per pixel, nonzero in each hole.
+vector<uint8_t> makeMask(Config const &c) {
+  vector<uint8_t> mask(c.size * c.size);
+  int             side= 1;
+  while(side * side < c.holes) ++side;
+  int const cell= c.size / side;
+  for(int h= 0; h < c.holes; ++h) {
+    int const r0= (h / side) * cell + cell / 2;
+    int const c0= (h % side) * cell + cell / 2;
+    for(int r= r0 - c.radius; r <= r0 + c.radius; ++r) {
+      for(int k= c0 - c.radius; k <= c0 + c.radius; ++k) {
+        int const dr= r - r0;
+        int const dc= k - c0;
+        if(dr * dr + dc * dc <= c.radius * c.radius) mask[r * c.size + k]= 1;
+      }
+    }
+  }
+  return mask;
+}
+
+
+/// Number of pixels to fill, so that rate of every engine is in same units,
+/// regardless of how many unknowns engine solves for.
+/// \param mask  Row-major mask, nonzero in each hole.
+/// \return      Number of nonzero pixels in mask.
+int countFilled(vector<uint8_t> const &mask) {
+  return int(std::count_if(
+        mask.begin(), mask.end(), [](uint8_t m) { return m != 0; }));
+}
+
+
+/// Make smooth image with noise.
+/// \tparam P  Type of pixel.
+/// \param  n  Number of rows and of columns.
+/// \return    Row-major image.
+template<typename P> vector<P> makeImage(int n) {
+  vector<P> image(n * n);
+  for(int r= 0; r < n; ++r) {
+    for(int c= 0; c < n; ++c) {
+      double const v= 100.0 + 50.0 * std::sin(0.05 * r) * std::cos(0.03 * c);
+      image[r * n + c]= P(v + std::rand() % 16);
+    }
+  }
+  return image;
+}
+
+
+/// Benchmark dirichlet::Fill.
+/// \tparam P       Type of pixel.
+/// \param  c       Combination of parameters.
+/// \param  method  Method for solving linear problem.
+/// \param  reps    Number of timed solutions.
+/// \return         Measurements.
+template<typename P>
+Result benchFill(Config const &c, dirichlet::Method method, int reps) {
+  vector<uint8_t> const mask = makeMask(c);
+  vector<P> const       image= makeImage<P>(c.size);
+  Result                res;
+  double const          t0= now();
+  dirichlet::Fill const f(mask.data(), c.size, c.size, 1, method);
+  res.construct= now() - t0;
+  res.filled   = countFilled(mask);
+  for(int i= 0; i < reps; ++i) {
+    vector<P>    copy= image;
+    double const t1  = now();
+    f(copy.data());
+    res.solve+= now() - t1;
+  }
+  res.solve/= reps;
+  res.iters= f.iterations();
+  return res;
+}
+
+
+/// Benchmark dirichlet::FillBiLin.
+/// \tparam P     Type of pixel.
+/// \param  c     Combination of parameters.
+/// \param  reps  Number of timed solutions.
+/// \return       Measurements.
+template<typename P> Result benchFillBiLin(Config const &c, int reps) {
+  vector<uint8_t> const mask = makeMask(c);
+  vector<P> const       image= makeImage<P>(c.size);
+  Result                res;
+  double const          t0= now();
+  dirichlet::FillBiLin  f(mask.data(), c.size, c.size);
+  res.construct= now() - t0;
+  // Interior of each square is filled but is not unknown.
+  res.filled= countFilled(mask);
+  for(int i= 0; i < reps; ++i) {
+    vector<P>    copy= image;
+    double const t1  = now();
+    f(copy.data());
+    res.solve+= now() - t1;
+  }
+  res.solve/= reps;
+  return res;
+}
+
+
+/// Benchmark regfill::image::laplacian_fill(), which constructs and solves
+/// in one call, so that whole call is timed as solution.
+/// \param  c     Combination of parameters.
+/// \param  reps  Number of timed solutions.
+/// \return       Measurements.
+Result benchRegfill(Config const &c, int reps) {
+  vector<uint8_t> const mask = makeMask(c);
+  vector<float> const   image= makeImage<float>(c.size);
+  uint16_t const        n    = uint16_t(c.size);
+  regfill::image        m(n, n);
+  regfill::image        im(n, n);
+  Result                res;
+  for(int r= 0; r < c.size; ++r) {
+    for(int k= 0; k < c.size; ++k) {
+      regfill::coords const p(k, r);
+      m(p) = mask[r * c.size + k];
+      im(p)= image[r * c.size + k];
+    }
+  }
+  res.filled= countFilled(mask);
+  for(int i= 0; i < reps; ++i) {
+    regfill::image copy= im;
+    double const   t1  = now();
+    copy.laplacian_fill(m);
+    res.solve+= now() - t1;
+  }
+  res.solve/= reps;
+  return res;
+}
+
+
+/// Benchmark one engine for type of pixel.
+/// \tparam P     Type of pixel.
+/// \param  c     Combination of parameters.
+/// \param  reps  Number of timed solutions.
+/// \return       Measurements.
+template<typename P> Result bench(Config const &c, int reps) {
+  switch(c.engine) {
+  case FILL_CHOLESKY: return benchFill<P>(c, dirichlet::CHOLESKY, reps);
+  case FILL_CG: return benchFill<P>(c, dirichlet::CG, reps);
+  case FILL_SCHUR: return benchFill<P>(c, dirichlet::SCHUR, reps);
+  case FILL_BILIN: return benchFillBiLin<P>(c, reps);
+  default: return benchRegfill(c, reps);
+  }
+}
+
+
+/// Write start of line of JSON for combination.
+/// \param c  Combination of parameters.
+void printConfig(Config const &c) {
+  std::printf("{\"engine\":\"%s\",\"pixel\":\"%s\",\"size\":%d,"
+              "\"holes\":%d,\"radius\":%d",
+              engineName[c.engine],
+              pixelName[c.pixel],
+              c.size,
+              c.holes,
+              c.radius);
+}
+
+
+/// Run one combination in child-process, and write its line of JSON.
+/// \param c     Combination of parameters.
+/// \param reps  Number of timed solutions.
+void run(Config const &c, int reps) {
+  std::fflush(stdout);
+  pid_t const pid= fork();
+  if(pid == 0) {
+    std::srand(1);
+    Result res;
+    try {
+      switch(c.pixel) {
+      case U8: res= bench<uint8_t>(c, reps); break;
+      case U16: res= bench<uint16_t>(c, reps); break;
+      default: res= bench<float>(c, reps); break;
+      }
+    } catch(char const *e) {
+      printConfig(c);
+      std::printf(",\"error\":\"%s\"}\n", e);
+      std::fflush(stdout);
+      _exit(1);
+    }
+    rusage ru;
+    getrusage(RUSAGE_SELF, &ru);
+    printConfig(c);
+    std::printf(",\"filled\":%d,\"construct_s\":%.6f,\"solve_s\":%.6f,"
+                "\"mpix_per_s\":%.3f,\"iterations\":%d,\"peak_rss_kb\":%ld}\n",
+                res.filled,
+                res.construct,
+                res.solve,
+                res.solve > 0 ? res.filled / res.solve * 1.0E-6 : 0.0,
+                res.iters,
+                long(ru.ru_maxrss));
+    std::fflush(stdout);
+    _exit(0);
+  }
+  int status= 0;
+  waitpid(pid, &status, 0);
+  if(WIFSIGNALED(status)) {
+    printConfig(c);
+    std::printf(",\"error\":\"signal %d\"}\n", WTERMSIG(status));
+  }
+}
+
+
+int main(int argc, char **argv) {
+  int const reps= (argc > 1 ? std::atoi(argv[1]) : 5);
+  for(int size: {256, 1024}) {
+    for(int holes: {1, 16}) {
+      // Largest radius makes hole deep enough for squares of FillBiLin to
+      // matter; it fits only in one hole at largest size.
+      for(int radius: {8, 32, 256}) {
+        // Each hole must lie within its own cell, away from edge of image.
+        int side= 1;
+        while(side * side < holes) ++side;
+        if(2 * radius + 2 >= size / side) continue;
+        for(int e= FILL_CHOLESKY; e <= REGFILL; ++e) {
+          for(int p= U8; p <= F32; ++p) {
+            // Legacy design works only in float, and slowly.
+            if(e == REGFILL && (p != F32 || size > 256)) continue;
+            run({Engine(e), Pixel(p), size, holes, radius}, reps);
+          }
+        }
+      }
+    }
+  }
+  return 0;
+}
+
+
+// EOF
@@ -21,7 +21,7 @@ using Eigen::seq;
 /// \param n  Minimum value to return.
 /// \param f  Factor required in return-value.
 /// \return   Of `f`, minimum multiple greater than or equal to `n`.
-int minMult(int n, int f) {
+inline int minMult(int n, int f) {
   int const j= n / f;
   if(j * f < n) return (j + 1) * f;
   return j * f;
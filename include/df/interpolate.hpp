@@ -44,8 +44,8 @@ template<typename T, typename U> void interpolate(T const &crn, U &cen) {
   if constexpr(is_same_v<S, float>) { // float
     cen= i;
   } else if constexpr(is_integral_v<S>) { // int8_t,  int16_t, etc.
-    auto const negativ= (i.array() < 0.0f).template cast<int>();
-    auto const positiv= 1 - negativ;
+    auto const negativ= (i.array() < 0.0f).template cast<S>();
+    auto const positiv= S(1) - negativ;
     auto const roundDn= (i.array() - 0.5f).template cast<S>();
     auto const roundUp= (i.array() + 0.5f).template cast<S>();
     /*      */ cen    = negativ * roundDn + positiv * roundUp;
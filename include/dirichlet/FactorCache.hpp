@@ -0,0 +1,236 @@
+/// \file       include/dirichlet/FactorCache.hpp
+/// \copyright  2022 Thomas E. Vaughan.  See terms in LICENSE.
+/// \brief      Definition of dirichlet::FactorCache.
+
+#ifndef DIRICHLET_FACTOR_CACHE_HPP
+#define DIRICHLET_FACTOR_CACHE_HPP
+
+#include "impl/Ldlt.hpp" // Ldlt
+#include <chrono>        // seconds
+#include <cstddef>       // size_t
+#include <cstdint>       // uint64_t
+#include <exception>     // current_exception
+#include <future>        // future_status, promise, shared_future
+#include <list>          // list
+#include <memory>        // shared_ptr
+#include <mutex>         // mutex, lock_guard
+#include <unordered_map> // unordered_multimap
+#include <vector>        // vector
+
+namespace dirichlet {
+
+
+/// Cache of Cholesky-decompositions, keyed by shape of connected component
+/// of filled pixels.
+///
+/// Matrix for component depends only on how its pixels neighbor one another,
+/// not on where component lies in image or on size of image.  So component
+/// whose shape has been seen before, in same instance of Fill or in another
+/// instance given same cache, shares existing decomposition; neither
+/// symbolic analysis nor numeric factorization is repeated.
+///
+/// Cache is safe for use by several threads at once.  Cache holds at most
+/// capacity() shapes; beyond that, least recently used shape is dropped.
+/// Instance of Fill keeps its own decompositions alive after they are
+/// dropped, by clear(), or by destruction of cache.
+///
+/// Each shape is stored as its runs of pixels, three integers for each run,
+/// and is found by 64-bit hash of them, so that memory for key is small
+/// beside that for decomposition.
+///
+/// \tparam S  Type of each coefficient of decomposition.
+template<typename S= float> class FactorCache {
+public:
+  /// Shape of component, independent of its location in image: for each
+  /// horizontal run of pixels, in row-major order, row and column of first
+  /// pixel of run, relative to first pixel of component, and number of pixels
+  /// in run.
+  using Key= std::vector<int>;
+
+  /// Shared, immutable decomposition.
+  using Factor= std::shared_ptr<impl::Ldlt<S> const>;
+
+private:
+  /// Decomposition, which is ready once its maker finishes.
+  using Entry= std::shared_future<Factor>;
+
+  /// Shape in cache.
+  struct Node {
+    uint64_t hash;  ///< Hash of shape.
+    Key      key;   ///< Shape.
+    Entry    entry; ///< Decomposition.
+  };
+
+  using List= std::list<Node>; ///< Type of list of shapes.
+
+  mutable std::mutex mutex_;     ///< Protect everything below.
+  std::size_t        cap_;       ///< Maximum number of shapes.
+  List               lru_;       ///< Shapes, most recently used first.
+  std::size_t        hits_  = 0; ///< Shapes found.
+  std::size_t        misses_= 0; ///< Shapes not found.
+
+  /// Shapes in lru_, by hash.
+  std::unordered_multimap<uint64_t, typename List::iterator> index_;
+
+  /// FNV-1a hash of shape.
+  /// \param k  Shape.
+  /// \return   Hash of shape.
+  static uint64_t hash(Key const &k) {
+    uint64_t h= 14695981039346656037ull;
+    for(int i: k) h= (h ^ uint32_t(i)) * 1099511628211ull;
+    return h;
+  }
+
+  /// Remove shape from lru_ and from index_.  Lock must be held.
+  /// \param i  Shape in lru_.
+  void erase(typename List::iterator i) {
+    auto const r= index_.equal_range(i->hash);
+    for(auto j= r.first; j != r.second; ++j) {
+      if(j->second == i) {
+        index_.erase(j);
+        break;
+      }
+    }
+    lru_.erase(i);
+  }
+
+  /// True if shape's decomposition has been made.
+  /// \param n  Shape.
+  /// \return   True if decomposition has been made.
+  static bool ready(Node const &n) {
+    auto const s= n.entry.wait_for(std::chrono::seconds(0));
+    return s == std::future_status::ready;
+  }
+
+  /// Drop least recently used shapes until no more than cap_ remain.  Shape
+  /// still being made is skipped, so that its maker finds it.  Lock must be
+  /// held.
+  void evict() {
+    auto i= lru_.end();
+    while(lru_.size() > cap_ && i != lru_.begin()) {
+      --i;
+      if(ready(*i)) erase(i++);
+    }
+  }
+
+public:
+  /// Construct empty cache.
+  /// \param capacity  Maximum number of shapes held.
+  explicit FactorCache(std::size_t capacity= 1024): cap_(capacity) {}
+
+  /// Find decomposition for shape, or make and store it.
+  ///
+  /// Lock is not held while `make` runs, so that different shapes are
+  /// decomposed in parallel.  Shape being made is entered in cache before
+  /// `make` runs, so that another thread asking for same shape waits for that
+  /// decomposition instead of making its own.  Each shape is thus made once
+  /// while it stays in cache, and counts of hits and misses do not depend on
+  /// timing of threads.
+  ///
+  /// If `make` throw, then shape is removed from cache, and exception is
+  /// passed to every thread waiting for shape.
+  ///
+  /// \tparam F     Type of function-object that makes decomposition.
+  /// \param  key   Shape of component.
+  /// \param  make  Function-object that returns new decomposition for shape.
+  /// \return       Decomposition for shape.
+  template<typename F> Factor get(Key const &key, F const &make) {
+    uint64_t const          h= hash(key);
+    std::promise<Factor>    p;
+    Entry                   e;
+    typename List::iterator mine;
+    {
+      std::lock_guard<std::mutex> lock(mutex_);
+      auto const                  r= index_.equal_range(h);
+      for(auto j= r.first; j != r.second; ++j) {
+        if(j->second->key == key) {
+          ++hits_;
+          lru_.splice(lru_.begin(), lru_, j->second);
+          e= j->second->entry;
+          break;
+        }
+      }
+      if(!e.valid()) {
+        ++misses_;
+        lru_.push_front(Node{h, key, p.get_future().share()});
+        mine= lru_.begin();
+        index_.emplace(h, mine);
+        evict();
+      }
+    }
+    // Wait, without lock, for thread that makes shape.
+    if(e.valid()) return e.get();
+    try {
+      Factor const f= make();
+      p.set_value(f);
+      return f;
+    } catch(...) {
+      {
+        // Shape being made is never evicted, so that it is still here.
+        std::lock_guard<std::mutex> lock(mutex_);
+        erase(mine);
+      }
+      p.set_exception(std::current_exception());
+      throw;
+    }
+  }
+
+  /// Maximum number of shapes held.
+  /// \return  Maximum number of shapes held.
+  std::size_t capacity() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return cap_;
+  }
+
+  /// Change maximum number of shapes held, and drop least recently used
+  /// shapes beyond it.
+  /// \param capacity  Maximum number of shapes held.
+  void setCapacity(std::size_t capacity) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    cap_= capacity;
+    evict();
+  }
+
+  /// Number of shapes in cache.
+  /// \return  Number of shapes in cache.
+  std::size_t size() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return lru_.size();
+  }
+
+  /// Number of lookups that found shape already in cache.
+  /// \return  Number of lookups that found shape.
+  std::size_t hits() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return hits_;
+  }
+
+  /// Number of lookups that did not find shape in cache.
+  /// \return  Number of lookups that did not find shape.
+  std::size_t misses() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return misses_;
+  }
+
+  /// Remove every shape from cache, except any still being made, and reset
+  /// counts.
+  void clear() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    for(auto i= lru_.begin(); i != lru_.end();) {
+      if(ready(*i)) {
+        erase(i++);
+      } else {
+        ++i;
+      }
+    }
+    hits_  = 0;
+    misses_= 0;
+  }
+};
+
+
+} // namespace dirichlet
+
+#endif // ndef DIRICHLET_FACTOR_CACHE_HPP
+
+// EOF
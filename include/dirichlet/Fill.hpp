@@ -1,11 +1,26 @@
 /// \file       include/dirichlet/Fill.hpp
 /// \copyright  2022 Thomas E. Vaughan.  See terms in LICENSE.
-/// \brief      Definition of dirichlet::Fill.
+/// \brief      Definition of dirichlet::BasicFill and dirichlet::Fill.
 
 #ifndef DIRICHLET_FILL_HPP
 #define DIRICHLET_FILL_HPP
 
+#include "FactorCache.hpp"     // FactorCache
+#include "Stats.hpp"           // Stats
+#include "impl/Amg.hpp"        // Amg
+#include "impl/Laplacian.hpp"  // Laplacian
+#include "impl/Ldlt.hpp"       // Ldlt
+#include "impl/MappedFile.hpp" // MappedFile
+#include "impl/Recorder.hpp"   // Recorder
+#include "impl/Schur.hpp"      // Schur
+#include <atomic>              // atomic
+#include <cstddef>             // size_t
+#include <cstdint>             // INT32_MAX, uint32_t, uint64_t
 #include <eigen3/Eigen/Sparse> // SparseMatrix
+#include <memory>              // unique_ptr
+#include <ostream>             // ostream
+#include <string>              // string
+#include <vector>              // vector
 
 /// Namespace for code that solves Dirichlet-problem for zero-valued Laplacian
 /// across specified pixels in image.
@@ -15,14 +30,59 @@ namespace dirichlet {
 using Eigen::ArrayX2i; // coords
 using Eigen::ArrayX4i;
 using Eigen::ArrayXi;
-using Eigen::ArrayXXf;
 using Eigen::ArrayXXi;
 using Eigen::ConjugateGradient;
+using Eigen::Dynamic;
+using Eigen::IdentityPreconditioner;
+using Eigen::IncompleteCholesky;
 using Eigen::Lower;
-using Eigen::SimplicialCholesky;
+using Eigen::Matrix;
+using Eigen::NaturalOrdering;
 using Eigen::SparseMatrix;
 using Eigen::Upper;
-using Eigen::VectorXf;
+using std::string;
+using std::unique_ptr;
+using std::vector;
+
+
+/// Method for solving linear problem in Fill.
+enum Method {
+  CHOLESKY,       ///< Sparse Cholesky-decomposition.
+  CG,             ///< Conjugate gradient, diagonal preconditioner.
+  CG_AMG,         ///< Conjugate gradient, algebraic-multigrid preconditioner.
+  CG_ICHOL,       ///< Conjugate gradient, incomplete-Cholesky preconditioner.
+  CG_MATRIX_FREE, ///< Conjugate gradient, matrix-free operator.
+  SOR,            ///< Red-black successive over-relaxation, in place.
+  SCHUR,          ///< Domain decomposition with Schur-complement.
+  CHOLESKY_MIXED  ///< Cholesky in float, refined iteratively in scalar-type.
+};
+
+
+/// Bit-packed mask.  Pixel at row `r` and column `c` is to be filled if bit
+/// `c % 64` (counting from least significant) of word `c / 64` in row be set.
+struct BitMask {
+  uint64_t const *words; ///< Pointer to first word of first row.
+  std::size_t     pitch; ///< Number of words from first of one row to next.
+};
+
+
+/// Run of pixels to be filled, in single row of run-length-encoded mask.
+struct Run {
+  int row;    ///< Row of every pixel in run.
+  int col;    ///< Column of first pixel in run.
+  int length; ///< Number of pixels in run.
+};
+
+
+/// Window, in larger canvas, onto image to be filled.  Every count is in
+/// instances of type of component, so that padded rows and interleaved
+/// components are described alike.
+struct View {
+  int pitch;     ///< Number of components from one row of canvas to next.
+  int stride= 1; ///< Number of components from one pixel to next.
+  int row   = 0; ///< Row    in canvas of top-left pixel of image.
+  int col   = 0; ///< Column in canvas of top-left pixel of image.
+};
 
 
 /// Fill holes in image by solving Dirichlet-problem for zero-valued Laplacian
@@ -31,120 +91,397 @@ using Eigen::VectorXf;
 /// Every pixel specified as to be filled must be in interior of image; no such
 /// pixel may be at edge of image.
 ///
-/// Instantiating `%Fill` does all preparatory work necessary to enable quick
-/// filling of same coordinates in one or more images of same size.
+/// Instantiating `%BasicFill` does all preparatory work necessary to enable
+/// quick filling of same coordinates in one or more images of same size.
 ///
 /// Filling image happens when instance is used as function-object.
-class Fill {
+///
+/// Filled pixels are grouped into connected components (4-connected, like
+/// Laplacian's stencil).  No component's solution depends on any other's, so
+/// for Cholesky-method each component gets its own, small decomposition, and
+/// components are decomposed and solved in parallel.
+///
+/// Linear problem is set up and solved in scalar-type `S`.  Double precision
+/// costs twice memory and bandwidth of single precision.  For double
+/// precision at nearly cost of single, CHOLESKY_MIXED decomposes in float and
+/// refines solution against residual computed in `S`.
+///
+/// \tparam S  Type of each coefficient in linear problem and in solution.
+template<typename S= float> class BasicFill {
   ArrayX2i coords_; ///< Coordinates of filled pixels in each image.
   unsigned wdth_;   ///< Number of columns in each image to fill.
   unsigned hght_;   ///< Number of rows    in each image to fill.
 
-  /// Map from rectangular coordinates of filled pixel to offset of same
-  /// coordinates in value returned by coords().  See documentation for
-  /// coordsMap().
-  ArrayXXi coordsMap_;
-
   /// Matrix with four columns to encode information about each neighbor of
   /// each filled pixel.  See documentation for lrtb().
   ArrayX4i lrtb_;
 
-  /// Square matrix for linear problem.
-  SparseMatrix<float> a_;
+  /// Offset, in coords(), of each filled pixel, grouped by connected
+  /// component.  Components are in descending order of size, and pixels in
+  /// each component are in row-major order, so that matrix of component
+  /// depends only on its shape.
+  ArrayXi compRows_;
+
+  /// Offset, in compRows_, of first pixel of each connected component, and,
+  /// at end, size of compRows_.
+  ArrayXi compBegin_;
 
-  /// Pointer to Cholesky-decomposition of square matrix for linear problem.
-  SimplicialCholesky<SparseMatrix<float>> *A_= nullptr;
+  /// Square matrix for linear problem.  Empty for matrix-free and Schur
+  /// methods.
+  SparseMatrix<S> a_;
+
+  /// Cholesky-decomposition of square matrix for each connected component.
+  /// Components of same shape share decomposition.
+  vector<typename FactorCache<S>::Factor> A_;
+
+  /// Single-precision Cholesky-decomposition for each connected component,
+  /// for mixed-precision method.
+  vector<FactorCache<float>::Factor> Af_;
+
+  /// Domain decomposition, for Schur-complement method.
+  unique_ptr<impl::Schur<S>> schur_;
+
+  /// File mapped into memory, if instance were loaded from file.  Each
+  /// decomposition in A_ then views memory in file.
+  unique_ptr<impl::MappedFile> file_;
 
   /// Workspace for conjugate-gradient approach.
-  ConjugateGradient<SparseMatrix<float>, Lower | Upper> CG_;
+  ConjugateGradient<SparseMatrix<S>, Lower | Upper> CG_;
 
-  /// True only if conjugate-gradient method should be used instead of
-  /// Cholesky.
-  bool cg_;
+  /// Workspace for conjugate-gradient approach with multigrid preconditioner.
+  ConjugateGradient<SparseMatrix<S>, Lower | Upper, impl::Amg<S>> AMG_;
 
-  /// Disallow copying because we store owned pointer.
-  Fill(Fill const &)= delete;
+  /// Workspace for conjugate-gradient approach with incomplete-Cholesky
+  /// preconditioner.  Natural ordering, which follows rows of image when
+  /// coordinates come from mask, preconditions better than AMD-ordering.
+  ConjugateGradient<
+        SparseMatrix<S>,
+        Lower | Upper,
+        IncompleteCholesky<S, Lower, NaturalOrdering<int>>>
+        IC_;
 
-  /// Disallow assignment because we store owned pointer.
-  Fill &operator=(Fill const &)= delete;
+  /// Matrix-free operator for linear problem.  Empty but for matrix-free
+  /// method.
+  impl::Laplacian<S> lap_;
 
-  /// coordsMap_ as single column.
-  /// \return  coordsMap_ as single column.
-  auto cmCol() const {
-    return Eigen::Map<ArrayXi const>(&coordsMap_(0, 0), wdth_ * hght_, 1);
-  }
+  /// Workspace for conjugate-gradient approach with matrix-free operator.
+  /// Diagonal of operator is constant, so diagonal preconditioner would do
+  /// nothing but scale.
+  ConjugateGradient<impl::Laplacian<S>, Lower | Upper, IdentityPreconditioner>
+        MF_;
 
-  /// Expression-template for array, of which each element `e` contains
-  /// code-value corresponding to some neighbor `n` of filled pixel `p`.
-  ///
-  /// Element `e` at offset `i` in returned array corresponds to `p`'s
-  /// coordinates at same offset `i` in value returned by coords().
-  ///
-  /// If `e < 0`, then `n` is not filled but in boundary of hole, and `n`'s
-  /// *row-major* linear offset in image is `-e - 1`.  (Arrays and matrices
-  /// used in Eigen are by default column-major, and they are column-major in
-  /// present library, but pixel-data fed into function-object are assumed to
-  /// be row-major.)
-  ///
-  /// Otherwise, `n` is itself also filled (like `p`), and `n` has coordinates
-  /// at offset `e` in value returned by coords().
-  ///
-  /// \tparam I  Type of expression for array of row   -coordinates.
-  /// \tparam J  Type of expression for array of column-coordinates.
-  /// \param  r  Array of row   -coordinates for neighbor-pixel.
-  /// \param  c  Array of column-coordinates for neighbor-pixel.
-  /// \return    Expression-template for columnar array of code-values.
-  template<typename I, typename J> auto nVal(I const &r, J const &c) const {
-    auto nLinColMaj= r + c * hght_;
-    auto nLinRowMaj= c + r * wdth_;
-    auto a         = cmCol()(nLinColMaj);
-    auto b         = (a == -1).template cast<int>();
-    return b * (-1 - nLinRowMaj) + (1 - b) * a;
-  }
+  /// For each filled pixel, row-major offset of nearest boundary-pixel in
+  /// each direction (left, right, top, bottom).  Empty for Cholesky and
+  /// Schur methods.
+  ArrayX4i guessOff_;
+
+  /// For each filled pixel, weight of each boundary-pixel in guessOff_.
+  /// Weight is inversely proportional to distance, and weights in each row
+  /// sum to unity.
+  Eigen::Array<S, Dynamic, 4> guessWgt_;
+
+  /// Row-major offset of each filled pixel for red-black SOR, red pixels
+  /// (even sum of row and column) first, each color in ascending order.
+  /// Empty but for SOR.
+  ArrayXi sorOff_;
+
+  /// Number of red pixels at beginning of sorOff_.
+  int sorRed_= 0;
+
+  /// Relaxation factor for SOR.
+  float omega_= 1.0f;
+
+  /// Largest number of sweeps for SOR.
+  int maxSweeps_= 0;
+
+  /// Tolerance for SOR.  See setTolerance().
+  S tol_= S(1.0E-5);
+
+  /// Largest number of steps of refinement for mixed-precision method.
+  static constexpr int maxRefinements= 10;
 
-  /// Expression-template for left neighbor via nVal().
-  auto nLft() const { return nVal(coords_.col(0), coords_.col(1) - 1); }
+  /// Number of iterations in most recent solution by operator().  Only
+  /// operator() writes it; solve() and sor() report through argument, so
+  /// that batch() need not touch it.  Atomic, so that threads calling
+  /// operator() at once on same instance do not race.
+  mutable std::atomic<int> iterations_{0};
 
-  /// Expression-template for right neighbor via nVal().
-  /// \return  Expression-template for columnar array of code-values.
-  auto nRgt() const { return nVal(coords_.col(0), coords_.col(1) + 1); }
+  /// Time spent in each phase.  Records nothing unless DIRICHLET_STATS be
+  /// defined.
+  mutable impl::Recorder rec_;
 
-  /// Expression-template for top neighbor via nVal().
-  /// \return  Expression-template for columnar array of code-values.
-  auto nTop() const { return nVal(coords_.col(0) - 1, coords_.col(1)); }
+  /// Method for solving linear problem.
+  Method method_;
 
-  /// Expression-template for bottom neighbor via nVal().
-  /// \return  Expression-template for columnar array of code-values.
-  auto nBot() const { return nVal(coords_.col(0) + 1, coords_.col(1)); }
+  /// Disallow copying because we store owned pointer.
+  BasicFill(BasicFill const &)= delete;
+
+  /// Disallow assignment because we store owned pointer.
+  BasicFill &operator=(BasicFill const &)= delete;
+
+  /// Initialize lrtb_ from coords_.
+  ///
+  /// Filled pixels are put in ascending order of row-major offset.  Then
+  /// neighbors in each direction are found by single pointer that only
+  /// advances, because offsets of neighbors ascend in same order.  Memory is
+  /// proportional to number of filled pixels, not to size of image.
+  void initLrtb();
+
+  /// Tag for constructor whose coordinates are known to lie in interior of
+  /// image, so that they need not be checked again.
+  struct Interior {};
+
+  /// Prepare for filling pixels known to lie in interior of image.
+  /// \param scan    Time-stamp at beginning of scan for coordinates.
+  /// \param coords  Coordinates of each pixel to be Dirichlet-filled.
+  /// \param width   Number of columns in image.
+  /// \param height  Number of rows in image.
+  /// \param method  Method for solving linear problem.
+  /// \param cache   Cache of decompositions, or null pointer.
+  BasicFill(Interior,
+            impl::Recorder::Stamp scan,
+            ArrayX2i            &&coords,
+            unsigned              width,
+            unsigned              height,
+            Method                method,
+            FactorCache<S>       *cache);
+
+  /// Initialize everything but coords_.
+  /// \param cache  Cache of decompositions, or null pointer.
+  void init(FactorCache<S> *cache);
+
+  /// Gather coordinates of every pixel to fill in interior of image, without
+  /// dense intermediate.  One pass counts pixels, and second pass stores
+  /// them.
+  /// \tparam R       Type of function-object called as `row(r, f)`, which
+  ///                 calls `f(c)` for each column `c` in `[1, width - 1)` to
+  ///                 fill in row `r`, in ascending order.
+  /// \param  width   Width of mask.
+  /// \param  height  Height of mask.
+  /// \param  row     Function-object that scans one row.
+  /// \return         Coordinates, in row-major order.
+  template<typename R>
+  static ArrayX2i gather(unsigned width, unsigned height, R const &row);
 
-  /// Find non-zero coordinates in `mask`.
+  /// Find non-zero coordinates in `mask`.  Mask of single-byte components
+  /// with unit stride is scanned many pixels at time.
   /// \tparam Comp    Type of each component in mask.
   /// \param  mask    Pointer to mask.
   /// \param  width   Width of mask.
   /// \param  height  Height of mask.
+  /// \param  stride  Number of instances of Comp between pixels.
+  /// \return         Coordinates, in row-major order.
   template<typename Comp>
   static ArrayX2i
   findCoords(Comp *mask, unsigned width, unsigned height, int stride);
 
+  /// Find coordinates of set bits in `mask`.
+  /// \param  mask    Bit-packed mask.
+  /// \param  width   Width of mask.
+  /// \param  height  Height of mask.
+  /// \return         Coordinates, in row-major order.
+  static ArrayX2i
+  findCoords(BitMask const &mask, unsigned width, unsigned height);
+
+  /// Find coordinates covered by `runs`, clipped to interior of image.
+  /// \param  runs    Runs of pixels to fill.
+  /// \param  width   Width of image.
+  /// \param  height  Height of image.
+  /// \return         Coordinates, in order of runs.
+  static ArrayX2i
+  findCoords(vector<Run> const &runs, unsigned width, unsigned height);
+
   /// Initialize square matrix for linear problem.
-  void initMatrix();
+  /// \param cache  Cache of decompositions, or null pointer.
+  void initMatrix(FactorCache<S> *cache);
+
+  /// Decompose matrix of each connected component, in parallel, largest
+  /// first.  Components of same shape share decomposition through `fc`.
+  /// \tparam F   Type of each coefficient in decomposition.
+  /// \param  fc  Cache of decompositions.
+  /// \param  f   Decomposition of each component, on return.
+  template<typename F>
+  void factorComponents(
+        FactorCache<F> &fc, vector<typename FactorCache<F>::Factor> &f);
+
+  /// Solve, for every column of `b`, against decomposition of each connected
+  /// component, in parallel, and scatter into rows of solution `x`, which is
+  /// resized only if its shape differ from that of `b`.
+  /// \tparam F  Type of each coefficient in decomposition.
+  /// \tparam B  Type of matrix of right-hand sides.
+  /// \tparam X  Type of matrix of solutions.
+  /// \param  f  Decomposition of each component.
+  /// \param  b  Right-hand sides, one per column.
+  /// \param  x  Solution, one column per right-hand side, on return.
+  template<typename F, typename B, typename X>
+  void solveComponents(vector<typename FactorCache<F>::Factor> const &f,
+                       B const                                       &b,
+                       X                                             &x) const;
+
+  /// Initialize compRows_ and compBegin_ by labeling connected components of
+  /// filled pixels.
+  void initComponents();
+
+  /// Initialize guessOff_ and guessWgt_ by walking from each filled pixel to
+  /// boundary in each direction.
+  void initGuess();
+
+  /// Layout of image stored compactly, in which offset of pixel in memory is
+  /// its row-major offset in image.
+  struct Compact {
+    /// Offset in memory of pixel.
+    /// \tparam P  Type of offset, either integer or Eigen-expression.
+    /// \param  p  Row-major offset of pixel in image.
+    /// \return    Same offset.
+    template<typename P> P operator()(P const &p) const { return p; }
+  };
+
+  /// Layout of image seen through View, in which offset of pixel in memory
+  /// is counted in components from top-left pixel of image.
+  struct Pitched {
+    int wdth;   ///< Number of pixels in each row of image.
+    int pitch;  ///< Number of components from one row to next.
+    int stride; ///< Number of components from one pixel to next.
+
+    /// Offset in memory of pixel.
+    /// \tparam P  Type of offset, either integer or Eigen-expression.
+    /// \param  p  Row-major offset of pixel in image.
+    /// \return    Offset in memory.
+    template<typename P> auto operator()(P const &p) const {
+      auto const r= p / wdth;
+      return r * pitch + (p - r * wdth) * stride;
+    }
+  };
 
-  /// Initialize coords_ (which pixels to fill), and initialize coordsMap_.
+  /// Interpolate initial guess for iterative method from boundary-values.
+  ///
+  /// Each filled pixel gets inverse-distance-weighted average of nearest
+  /// boundary-pixel to left, right, top, and bottom.  Along single row or
+  /// column, this is linear interpolation between ends.
+  ///
+  /// \tparam Map    Type of single-component or multiple-component image.
+  /// \tparam L      Type of layout, Compact or Pitched.
+  /// \param  image  Reference to image.
+  /// \param  lay    Layout of image in memory.
+  /// \return        Initial guess, one column per component.
+  template<typename Map, typename L>
+  Matrix<S, Dynamic, Map::ColsAtCompileTime>
+  guess(Map const &image, L const &lay) const;
+
+  /// Initialize coords_ (which pixels to fill).
   /// \param coords  Coordinates of each pixel to be Dirichlet-filled.
   void initCoords(ArrayX2i const &coords);
 
-  /// Calculate solution to linear system for one color-component of image.
-  /// \tparam Map    Type of single-component image.
-  /// \param  image  Reference to single-component image.
-  /// \return        Solution to linear system.
-  template<typename Map> VectorXf solve(Map const &image) const;
+  /// Header at beginning of file written by save().  Header is followed by
+  /// coords_, lrtb_, compRows_, and compBegin_; and then, for each
+  /// component, by number of rows, number of nonzeros, and whether there be
+  /// permutation; by factor's outer indices, inner indices, and values; by
+  /// diagonal; and, if present, by indices of permutation.  Every integer is
+  /// four bytes, and every coefficient is of type `S`, in native byte-order.
+  /// Each section begins at offset that is multiple of fileAlign, so that
+  /// decomposition can be used in place, where it lies in mapped file.
+  struct FileHeader {
+    char     magic[8]; ///< Identify file as written by save().
+    uint32_t version;  ///< Version of format.
+    uint32_t method;   ///< Method for solving linear problem.
+    uint32_t scalar;   ///< Number of bytes in each coefficient.
+    uint32_t width;    ///< Number of columns in image.
+    uint32_t height;   ///< Number of rows in image.
+    int32_t  nCoords;  ///< Number of filled pixels.
+    int32_t  nComps;   ///< Number of connected components.
+  };
+
+  /// Version of format written by save().
+  static constexpr uint32_t fileVersion= 3;
+
+  /// Alignment of each section of file written by save().
+  static constexpr std::size_t fileAlign=
+        (alignof(S) > alignof(int) ? alignof(S) : alignof(int));
+
+  /// Initialize sorOff_, sorRed_, omega_, and maxSweeps_.
+  ///
+  /// Relaxation factor is optimal one for rectangle whose sides are longest
+  /// horizontal and longest vertical run of filled pixels.
+  void initSor();
+
+  /// Relax filled pixels in place by red-black SOR until largest change in
+  /// sweep be small relative to largest value.
+  ///
+  /// Pixels of one color depend only on pixels of other color, so each half
+  /// of each sweep is divided into chunks that run in parallel.
+  ///
+  /// \tparam Map     Type of single-component image.
+  /// \tparam L       Type of layout, Compact or Pitched.
+  /// \param  image   Reference to image.
+  /// \param  sweeps  Number of sweeps, on return.
+  /// \param  lay     Layout of image in memory.
+  template<typename Map, typename L= Compact>
+  void sor(Map &image, int &sweeps, L const &lay= L()) const;
+
+  /// Workspace for solution of one image.  Thread of batch() keeps its own
+  /// from image to image, so that right-hand side and solution are not
+  /// allocated anew for each image.
+  /// \tparam Cols  Number of columns, or Eigen::Dynamic.
+  template<int Cols> struct Workspace {
+    Matrix<S, Dynamic, Cols> b; ///< Right-hand side, column per component.
+    Matrix<S, Dynamic, Cols> x; ///< Solution, column per component.
+    typename impl::Schur<S>::Workspace schur; ///< Scratch for SCHUR.
+    Matrix<S, Dynamic, 1> r; ///< Residual, for conjugate gradient.
+    Matrix<S, Dynamic, 1> z; ///< Preconditioned residual.
+    Matrix<S, Dynamic, 1> p; ///< Direction of search.
+    Matrix<S, Dynamic, 1> q; ///< Product of matrix and direction.
+  };
+
+  /// Calculate solution to linear system for each color-component of image.
+  ///
+  /// Boundary-values for every component are gathered in one pass over image,
+  /// and there is one column of right-hand side for each component.
+  ///
+  /// No member is modified, so that several threads may solve at once.
+  ///
+  /// \tparam Map    Type of single-component or multiple-component image.
+  /// \tparam L      Type of layout, Compact or Pitched.
+  /// \param  image  Reference to image; each row is pixel, each column is
+  ///                component.
+  /// \param  w      Workspace; on return, `w.x` is solution to linear system,
+  ///                one column per component.
+  /// \param  iters  Number of iterations, on return.
+  /// \param  lay    Layout of image in memory.
+  template<typename Map, typename L= Compact>
+  void solve(Map const                         &image,
+             Workspace<Map::ColsAtCompileTime> &w,
+             int                               &iters,
+             L const                           &lay= L()) const;
+
+  /// Solve by preconditioned conjugate gradient for every column of `b`.
+  /// Solver `cg` supplies only preconditioner, limit on iterations, and
+  /// tolerance, and is not modified, so that several threads may share it.
+  /// Vectors of iteration live in workspace of calling thread, so that they
+  /// are not allocated anew for each image.
+  /// \tparam C      Type of Eigen::ConjugateGradient.
+  /// \tparam M      Type of matrix or of matrix-free operator.
+  /// \tparam B      Type of matrix of right-hand sides.
+  /// \tparam X      Type of matrix of solutions.
+  /// \tparam W      Type of workspace.
+  /// \param  cg     Solver, already computed.
+  /// \param  m      Matrix or operator.
+  /// \param  b      Right-hand sides, one per column.
+  /// \param  x      Initial guesses, and, on return, solutions.
+  /// \param  w      Workspace.
+  /// \param  err    Largest relative residual for any column, on return.
+  /// \return        Largest number of iterations for any column.
+  template<typename C, typename M, typename B, typename X, typename W>
+  static int cg(C const &cg, M const &m, B const &b, X &x, W &w, S &err);
 
   /// Copy solution back into original image.
-  /// \tparam Map    Type of single-component image.
-  /// \param  image  Reference to single-component image.
-  /// \param  x      Solution.
-  template<typename Map>
-  void copySolutionBackIntoImage(Map &im, VectorXf const &x) const;
+  /// \tparam Map    Type of single-component or multiple-component image.
+  /// \tparam X      Type of solution.
+  /// \tparam L      Type of layout, Compact or Pitched.
+  /// \param  image  Reference to image.
+  /// \param  x      Solution, one column per component.
+  /// \param  lay    Layout of image in memory.
+  template<typename Map, typename X, typename L= Compact>
+  void copySolutionBackIntoImage(Map &im, X const &x, L const &lay= L()) const;
 
 public:
   /// Prepare for filling one or more single-component images of size
@@ -160,15 +497,34 @@ public:
   /// specified in `coords` be on our outside of image's edge, then that pixel
   /// is ignored; no corresponding pixel in image will be filled.
   ///
+  /// For Cholesky-method, connected components of same shape share
+  /// decomposition.  If `cache` be supplied, then components share
+  /// decomposition also with components of same shape in other instances
+  /// made with same cache, regardless of location or size of image.  Cache
+  /// is not used for single-precision decompositions of mixed-precision
+  /// method unless `S` be float.
+  ///
+  /// \param coords  Coordinates of each pixel to be Dirichlet-filled.
+  /// \param width   Number of columns in image.
+  /// \param height  Number of rows in image.
+  /// \param method  Method for solving linear problem.
+  /// \param cache   Cache of decompositions, or null pointer.
+  ///
+  BasicFill(ArrayX2i const &coords,
+            unsigned        width,
+            unsigned        height,
+            Method          method= CHOLESKY,
+            FactorCache<S> *cache = nullptr);
+
+  /// Prepare for filling, as above, by either Cholesky or conjugate gradient.
+  ///
   /// \param coords  Coordinates of each pixel to be Dirichlet-filled.
   /// \param width   Number of columns in image.
   /// \param height  Number of rows in image.
   /// \param cg      True if conjugate-gradient method should be used.
   ///
-  Fill(ArrayX2i const &coords,
-       unsigned        width,
-       unsigned        height,
-       bool            cg= false);
+  BasicFill(ArrayX2i const &coords, unsigned width, unsigned height, bool cg):
+      BasicFill(coords, width, height, cg ? CG : CHOLESKY) {}
 
   /// Prepare for filling one or more single-component images of size
   /// `width*height`; pixels to fill are given by non-zero pixels in `mask`.
@@ -194,20 +550,87 @@ public:
   /// \param  stride  Number of instances of type Comp between component of one
   ///                 pixel and corresponding component of next pixel.
   ///
-  /// \param cg       True if conjugate-gradient method should be used instead
-  ///                 of Cholesky.
+  /// \param method   Method for solving linear problem.
+  /// \param cache    Cache of decompositions, or null pointer.
+  ///
+  template<typename Comp>
+  BasicFill(Comp           *mask,
+            unsigned        width,
+            unsigned        height,
+            int             stride= 1,
+            Method          method= CHOLESKY,
+            FactorCache<S> *cache = nullptr);
+
+  /// Prepare for filling, as above, by either Cholesky or conjugate gradient.
+  ///
+  /// \tparam Comp    Type of each component of each pixel.
+  /// \param  mask    Pointer to image whose non-zero pixels are to be filled.
+  /// \param  width   Number of columns in image.
+  /// \param  height  Number of rows in image.
+  /// \param  stride  Number of instances of type Comp between pixels.
+  /// \param  cg      True if conjugate-gradient method should be used.
   ///
   template<typename Comp>
-  Fill(Comp    *mask,
-       unsigned width,
-       unsigned height,
-       int      stride= 1,
-       bool     cg    = false);
+  BasicFill(Comp *mask, unsigned width, unsigned height, int stride, bool cg):
+      BasicFill(mask, width, height, stride, cg ? CG : CHOLESKY) {}
+
+  /// Prepare for filling, as above, pixels whose bits are set in bit-packed
+  /// mask.  Words that are zero are skipped sixty-four pixels at time.
+  ///
+  /// \param mask    Bit-packed mask.
+  /// \param width   Number of columns in image.
+  /// \param height  Number of rows in image.
+  /// \param method  Method for solving linear problem.
+  /// \param cache   Cache of decompositions, or null pointer.
+  ///
+  BasicFill(BitMask const  &mask,
+            unsigned        width,
+            unsigned        height,
+            Method          method= CHOLESKY,
+            FactorCache<S> *cache = nullptr);
+
+  /// Prepare for filling, as above, pixels covered by run-length-encoded
+  /// mask.  Runs must not overlap, but they may be in any order, which is
+  /// order of rows in coords().  Part of any run on or outside of edge of
+  /// image is ignored.
+  ///
+  /// \param runs    Runs of pixels to fill.
+  /// \param width   Number of columns in image.
+  /// \param height  Number of rows in image.
+  /// \param method  Method for solving linear problem.
+  /// \param cache   Cache of decompositions, or null pointer.
+  ///
+  BasicFill(vector<Run> const &runs,
+            unsigned           width,
+            unsigned           height,
+            Method             method= CHOLESKY,
+            FactorCache<S>    *cache = nullptr);
+
+  /// Load instance, ready to solve, from file written by save().
+  ///
+  /// File is mapped into memory, and decomposition is used where it lies in
+  /// file, so that nothing is decomposed again, and pages of decomposition
+  /// are read from disk only when first needed.  Coordinates, neighbors, and
+  /// components, which are small beside decomposition, are copied out of
+  /// mapping into arrays of instance.  Matrix returned by a() is empty.
+  ///
+  /// Throw exception if file cannot be mapped, if file be not of right
+  /// format, version, and scalar-type, or if file be truncated.
+  ///
+  /// \param path  Path of file.
+  explicit BasicFill(string const &path);
 
   /// Deallocate Cholesky-decomposition.
-  virtual ~Fill() {
-    if(A_ != nullptr) delete A_;
-  }
+  virtual ~BasicFill()= default;
+
+  /// Write coordinates, neighbors, connected components, and Cholesky-
+  /// decomposition to file, for loading later by constructor.
+  ///
+  /// Throw exception if method be other than Cholesky or if file cannot be
+  /// written.
+  ///
+  /// \param path  Path of file.
+  void save(string const &path) const;
 
   /// Coordinates of each filled pixel.
   /// \return  Coordinates of each filled pixel.
@@ -247,7 +670,67 @@ public:
   /// \return        Solution to linear system.
   ///
   template<typename Comp>
-  VectorXf operator()(Comp *image, int stride= 1) const;
+  Matrix<S, Dynamic, 1> operator()(Comp *image, int stride= 1) const;
+
+  /// Fill pixels by calculating solution to linear system for each of first
+  /// `nComp` color-components of interleaved image.
+  ///
+  /// Boundary-values for all components are gathered in single pass over
+  /// image, and all components are solved for together against same
+  /// factorization.  For Cholesky, this costs little more than solving for
+  /// single component.
+  ///
+  /// Each row in solution corresponds to different pixel, in same order as
+  /// rows in coords(); each column corresponds to different component.
+  ///
+  /// If template-parameter `Comp` be non-const type, then solution is not just
+  /// returned but also (converted to `Comp` if necessary and) copied back into
+  /// image.
+  ///
+  /// Throw exception if `nComp` be larger than `stride`.
+  ///
+  /// \tparam Comp   Type of each component in image.
+  ///
+  /// \param image   Pointer to first component of first pixel in row-major
+  ///                image with interleaved components.
+  ///
+  /// \param stride  Number of instances of type Comp between component of one
+  ///                pixel and corresponding component of next pixel.
+  ///
+  /// \param nComp   Number of components, starting with first in each pixel,
+  ///                to fill.
+  ///
+  /// \return        Solution to linear system, one column per component.
+  ///
+  template<typename Comp>
+  Matrix<S, Dynamic, Dynamic>
+  operator()(Comp *image, int stride, int nComp) const;
+
+  /// Fill pixels of image that is window onto larger canvas, in place.
+  ///
+  /// Image need be neither copied out of canvas nor copied back.  Boundary-
+  /// values are gathered from, and solution is written into, canvas's own
+  /// memory, whatever be padding at end of each row of canvas and wherever in
+  /// canvas image begin.  Otherwise, same as operator()(Comp*, int, int).
+  ///
+  /// Throw exception if `nComp` be larger than `view.stride`.
+  ///
+  /// \tparam Comp    Type of each component in image.
+  ///
+  /// \param  canvas  Pointer to first component of top-left pixel of canvas.
+  ///
+  /// \param  view    Pitch and stride of canvas, and offset in canvas of
+  ///                 image, whose width and height are those supplied to
+  ///                 constructor.
+  ///
+  /// \param  nComp   Number of components, starting with first in each pixel,
+  ///                 to fill.
+  ///
+  /// \return         Solution to linear system, one column per component.
+  ///
+  template<typename Comp>
+  Matrix<S, Dynamic, Dynamic>
+  operator()(Comp *canvas, View const &view, int nComp= 1) const;
 
   /// Map from rectangular coordinates of filled pixel to offset of same
   /// coordinates in value returned by coords().
@@ -257,13 +740,17 @@ public:
   /// filled.  If coordinates be for filling, then element contains offset of
   /// same coordinates in value returned by coords().
   ///
-  /// Array is empty if any specified coordinates be out of bounds.
-  /// (Coordinates on edge of image are out of bounds for filling.)
+  /// Map is not stored but built on each call, at cost of four bytes per
+  /// pixel of image.  Nothing else in instance depends on size of image.
   ///
   /// \return  Map from rectangular coordinates of filled pixel to offset of
   ///          same coordinates in value returned by coords().
   ///
-  ArrayXXi const &coordsMap() const { return coordsMap_; }
+  ArrayXXi coordsMap() const {
+    ArrayXXi m= ArrayXXi::Constant(hght_, wdth_, -1);
+    for(int i= 0; i < coords_.rows(); ++i) m(coords_(i, 0), coords_(i, 1))= i;
+    return m;
+  }
 
   /// Matrix with each row corresponding to different filled pixel `p` and with
   /// four columns, each corresponding to different neighbor `n` of `p`.  Row
@@ -279,58 +766,351 @@ public:
   /// \return  Matrix with four columns to encode information about each
   ///          neighbor of each filled pixel.
   ArrayX4i const &lrtb() const { return lrtb_; }
+
+  /// Square matrix for linear problem, or empty matrix for matrix-free and
+  /// Schur methods.
+  /// \return  Square matrix for linear problem.
+  SparseMatrix<S> const &a() const { return a_; }
+
+  /// Method for solving linear problem.
+  /// \return  Method for solving linear problem.
+  Method method() const { return method_; }
+
+  /// Fill every image in range, in parallel, and write solution back into
+  /// each image.
+  ///
+  /// Images are handed out one at a time to threads of shared pool, so that
+  /// fast and slow images balance across threads, and each thread reuses its
+  /// own workspace from image to image.  No member is modified, so batch()
+  /// is safe for every method; iterations() is not updated.
+  ///
+  /// Throw exception if `nComp` be larger than `stride` or if method be SOR
+  /// and `Comp` be not floating-point.
+  ///
+  /// \tparam It      Type of random-access iterator over pointers to
+  ///                 non-const images, like `Comp **` or iterator of
+  ///                 `std::vector<Comp *>`.
+  /// \param  begin   Iterator to pointer to first image.
+  /// \param  end     Iterator past pointer to last image.
+  /// \param  stride  Number of instances of component between component of
+  ///                 one pixel and corresponding component of next pixel.
+  /// \param  nComp   Number of components, starting with first in each pixel,
+  ///                 to fill.
+  ///
+  template<typename It>
+  void batch(It begin, It end, int stride= 1, int nComp= 1) const;
+
+  /// Number of iterations (sweeps for SOR, steps of refinement for
+  /// mixed-precision, largest for any component) taken by most recent
+  /// solution by operator(), or zero for Cholesky-method.
+  /// \return  Number of iterations taken by most recent solution.
+  int iterations() const { return iterations_; }
+
+  /// Time spent in each phase, and size of linear problem.  Times are
+  /// recorded only when DIRICHLET_STATS is defined at compile-time.
+  /// \return  Time spent in each phase, and size of linear problem.
+  Stats stats() const;
+
+  /// Write every phase recorded so far as Chrome-trace JSON.
+  /// \param os  Stream to which to write.
+  void trace(std::ostream &os) const { rec_.trace(os); }
+
+  /// Set tolerance for iterative methods.
+  ///
+  /// For conjugate gradient, iteration stops when norm of residual be less
+  /// than `tol` times norm of right-hand side; default is Eigen's (machine
+  /// epsilon).  For SOR, iteration stops when no pixel change by more than
+  /// `tol` times largest filled value in single sweep; default is 1.0E-5.
+  ///
+  /// \param  tol  Tolerance.
+  /// \return      Reference to this instance.
+  BasicFill &setTolerance(S tol) {
+    CG_.setTolerance(tol);
+    AMG_.setTolerance(tol);
+    IC_.setTolerance(tol);
+    MF_.setTolerance(tol);
+    tol_= tol;
+    return *this;
+  }
+
+  /// Number of connected components of filled pixels, or zero for SOR.
+  /// \return  Number of connected components of filled pixels.
+  int components() const { return int(compBegin_.size()) - 1; }
 };
 
 
+/// Fill in single precision, which is usual case.  Other precision is named
+/// as BasicFill<double>.
+using Fill= BasicFill<float>;
+
+
 } // namespace dirichlet
 
 // Implementation below.
 
+#include "impl/ThreadPool.hpp" // ThreadPool
+#include "impl/maskScan.hpp"   // forEachNonZero, forEachSetBit
+#include <algorithm>           // all_of, is_sorted, sort, stable_partition
+#include <cmath>               // cos, sqrt
+#include <cstring>             // memcmp, memcpy
+#include <fstream>             // ofstream
+#include <iterator>            // iterator_traits
+#include <limits>              // numeric_limits
+#include <numeric>             // iota
+#include <type_traits>         // remove_pointer_t
+
 namespace dirichlet {
 
 
 using Eigen::Array;
-using Eigen::Array2i;
-using Eigen::Dynamic;
 using Eigen::RowMajor;
 using Eigen::Triplet;
 using Eigen::Unaligned;
+using std::conditional_t;
 using std::is_const_v;
 using std::is_floating_point_v;
 using std::is_integral_v;
 using std::is_same_v;
 using std::is_unsigned_v;
-using std::vector;
+using std::make_unique;
+using std::remove_const_t;
 
 
-void Fill::initMatrix() {
-  vector<Triplet<float>> t;
+template<typename S> void BasicFill<S>::initMatrix(FactorCache<S> *cache) {
+  if(method_ == CG_MATRIX_FREE) {
+    {
+      impl::Scope const s(rec_, ASSEMBLY);
+      lap_= impl::Laplacian<S>(lrtb_);
+    }
+    impl::Scope const s(rec_, FACTOR);
+    MF_.compute(lap_);
+    return;
+  }
+  if(method_ == SCHUR) {
+    impl::Scope const s(rec_, FACTOR);
+    schur_= make_unique<impl::Schur<S>>(coords_, lrtb_);
+    return;
+  }
+  auto const         start= impl::Recorder::now();
+  vector<Triplet<S>> t;
   // At *most* five coefficients in matrix for each filled pixel.  Fewer than
   // five coefficients for each filled pixel that touches boundary of hole to
   // fill.  Only one coefficient for each filled pixel that touches no other
   // filled pixel (for filled pixel that touches only boundary-pixels).
   t.reserve(coords_.rows() * 5);
   for(int i= 0; i < coords_.rows(); ++i) {
-    t.push_back({i, i, 4.0f});
+    t.push_back({i, i, S(4)});
     int const lft= lrtb_(i, 0);
     int const rgt= lrtb_(i, 1);
     int const top= lrtb_(i, 2);
     int const bot= lrtb_(i, 3);
-    if(lft >= 0) t.push_back({i, lft, -1.0f});
-    if(rgt >= 0) t.push_back({i, rgt, -1.0f});
-    if(top >= 0) t.push_back({i, top, -1.0f});
-    if(bot >= 0) t.push_back({i, bot, -1.0f});
+    if(lft >= 0) t.push_back({i, lft, S(-1)});
+    if(rgt >= 0) t.push_back({i, rgt, S(-1)});
+    if(top >= 0) t.push_back({i, top, S(-1)});
+    if(bot >= 0) t.push_back({i, bot, S(-1)});
   }
+  a_.resize(coords_.rows(), coords_.rows());
   a_.setFromTriplets(t.begin(), t.end());
-  if(cg_) {
-    CG_.compute(a_);
-  } else {
-    A_= new SimplicialCholesky<SparseMatrix<float>>(a_);
+  rec_.add(ASSEMBLY, start, impl::Recorder::now());
+  impl::Scope const s(rec_, FACTOR);
+  switch(method_) {
+  case CG: CG_.compute(a_); return;
+  case CG_AMG: AMG_.compute(a_); return;
+  case CG_ICHOL: IC_.compute(a_); return;
+  default: break;
   }
+  if(method_ == CHOLESKY_MIXED) {
+    // Matrix is kept for residual; decompositions are single-precision.
+    FactorCache<float> own;
+    if constexpr(is_same_v<S, float>) {
+      factorComponents(cache ? *cache : own, Af_);
+    } else {
+      factorComponents(own, Af_);
+    }
+    return;
+  }
+  // Without cache from caller, share decompositions only within instance.
+  FactorCache<S> own;
+  factorComponents(cache ? *cache : own, A_);
 }
 
 
-void Fill::initCoords(ArrayX2i const &coords) {
+template<typename S>
+template<typename F>
+void BasicFill<S>::factorComponents(
+      FactorCache<F> &fc, vector<typename FactorCache<F>::Factor> &f) {
+  // Offset of each filled pixel within its own component.
+  ArrayXi local(coords_.rows());
+  for(int c= 0; c < components(); ++c) {
+    for(int k= compBegin_(c); k < compBegin_(c + 1); ++k) {
+      local(compRows_(k))= k - compBegin_(c);
+    }
+  }
+  f.resize(components());
+  impl::ThreadPool::global().run(components(), [&](int c) {
+    int const b= compBegin_(c);
+    int const n= compBegin_(c + 1) - b;
+    auto const rows= compRows_.segment(b, n);
+    // Shape of component, independent of its location in image, as runs of
+    // pixels in row-major order.  Each pixel whose left neighbor is in
+    // boundary begins run.
+    typename FactorCache<F>::Key key;
+    int const                    r0= coords_(rows(0), 0);
+    int const                    c0= coords_(rows(0), 1);
+    for(int k= 0; k < n; ++k) {
+      int const i= rows(k);
+      if(k == 0 || lrtb_(i, 0) < 0) {
+        key.insert(key.end(), {coords_(i, 0) - r0, coords_(i, 1) - c0, 0});
+      }
+      ++key.back();
+    }
+    f[c]= fc.get(key, [&] {
+      vector<Triplet<F>> tc;
+      tc.reserve(n * 5);
+      for(int k= 0; k < n; ++k) {
+        tc.push_back({k, k, F(4)});
+        for(int d= 0; d < 4; ++d) {
+          int const j= lrtb_(rows(k), d);
+          if(j >= 0) tc.push_back({k, local(j), F(-1)});
+        }
+      }
+      SparseMatrix<F> ac(n, n);
+      ac.setFromTriplets(tc.begin(), tc.end());
+      return std::make_shared<impl::Ldlt<F> const>(ac);
+    });
+  });
+}
+
+
+template<typename S> void BasicFill<S>::initGuess() {
+  int const n= int(coords_.rows());
+  guessOff_.resize(n, 4);
+  ArrayX4i    dist= ArrayX4i::Zero(n, 4); // Zero until known.
+  vector<int> chain; // Filled pixels waiting for distance.
+  for(int d= 0; d < 4; ++d) {
+    for(int i= 0; i < n; ++i) {
+      // Walk toward boundary until reaching boundary or known distance.
+      for(int j= i; dist(j, d) == 0;) {
+        int const k= lrtb_(j, d);
+        if(k < 0) {
+          dist(j, d)     = 1;
+          guessOff_(j, d)= -1 - k;
+        } else if(dist(k, d) > 0) {
+          dist(j, d)     = dist(k, d) + 1;
+          guessOff_(j, d)= guessOff_(k, d);
+        } else {
+          chain.push_back(j);
+          j= k;
+        }
+      }
+      // Unwind walk, so that every pixel is visited once per direction.
+      while(!chain.empty()) {
+        int const j= chain.back();
+        int const k= lrtb_(j, d);
+        chain.pop_back();
+        dist(j, d)     = dist(k, d) + 1;
+        guessOff_(j, d)= guessOff_(k, d);
+      }
+    }
+  }
+  Eigen::Array<S, Dynamic, 4> const w= dist.cast<S>().inverse();
+  guessWgt_       = w.colwise() / w.rowwise().sum();
+}
+
+
+template<typename S> void BasicFill<S>::initSor() {
+  // Sort row-major and column-major offsets.
+  ArrayXi off= coords_.col(0) * wdth_ + coords_.col(1);
+  ArrayXi tr = coords_.col(1) * hght_ + coords_.col(0);
+  std::sort(off.begin(), off.end());
+  std::sort(tr.begin(), tr.end());
+  // Longest run of consecutive offsets.  Pixels on edge are never filled, so
+  // run cannot wrap from one row (or column) to next.
+  auto const run= [](ArrayXi const &a) {
+    int longest= 0;
+    for(int i= 0, n= 0; i < a.size(); ++i) {
+      n= (i > 0 && a(i) == a(i - 1) + 1) ? n + 1 : 1;
+      if(n > longest) longest= n;
+    }
+    return longest;
+  };
+  int const    h  = run(off);
+  int const    v  = run(tr);
+  double const pi = 3.14159265358979323846;
+  double const rho= (std::cos(pi / (h + 1)) + std::cos(pi / (v + 1))) / 2;
+  omega_          = float(2 / (1 + std::sqrt(1 - rho * rho)));
+  maxSweeps_      = 10 * (std::max(h, v) + 1);
+  // Red pixels first.
+  int const w= int(wdth_);
+  auto      r= std::stable_partition(off.begin(), off.end(), [w](int p) {
+    return (p / w + p % w) % 2 == 0;
+  });
+  sorRed_= int(r - off.begin());
+  sorOff_= off;
+}
+
+
+template<typename S> void BasicFill<S>::initComponents() {
+  int const n= int(coords_.rows());
+  // Union-find, with path-halving, over links between filled neighbors.
+  ArrayXi    parent= ArrayXi::LinSpaced(n, 0, n - 1);
+  auto const root  = [&](int i) {
+    while(parent(i) != i) i= parent(i)= parent(parent(i));
+    return i;
+  };
+  for(int i= 0; i < n; ++i) {
+    // Right and bottom suffice because links are symmetric.
+    for(int d= 1; d < 4; d+= 2) {
+      int const j= lrtb_(i, d);
+      if(j < 0) continue;
+      int const ri= root(i);
+      int const rj= root(j);
+      if(ri != rj) parent(std::max(ri, rj))= std::min(ri, rj);
+    }
+  }
+  // Label each component and count its pixels.
+  ArrayXi     label(n);
+  vector<int> size;
+  for(int i= 0; i < n; ++i) {
+    int const r= root(i);
+    if(r == i) {
+      label(i)= int(size.size());
+      size.push_back(0);
+    } else {
+      label(i)= label(r); // Root precedes every other pixel in component.
+    }
+    ++size[label(i)];
+  }
+  // Sort components by descending size for balance across threads.
+  int const   nc= int(size.size());
+  vector<int> order(nc);
+  std::iota(order.begin(), order.end(), 0);
+  std::stable_sort(order.begin(), order.end(), [&](int x, int y) {
+    return size[x] > size[y];
+  });
+  ArrayXi rank(nc);
+  compBegin_.resize(nc + 1);
+  compBegin_(0)= 0;
+  for(int c= 0; c < nc; ++c) {
+    rank(order[c])    = c;
+    compBegin_(c + 1)= compBegin_(c) + size[order[c]];
+  }
+  // Visit pixels in row-major order, which is usually that of coords_.
+  ArrayXi const off= coords_.col(0) * int(wdth_) + coords_.col(1);
+  vector<int>   scan(n);
+  std::iota(scan.begin(), scan.end(), 0);
+  if(!std::is_sorted(off.begin(), off.end())) {
+    std::stable_sort(scan.begin(), scan.end(), [&](int a, int b) {
+      return off(a) < off(b);
+    });
+  }
+  ArrayXi next= compBegin_.head(nc);
+  compRows_.resize(n);
+  for(int i: scan) compRows_(next(rank(label(i)))++)= i;
+}
+
+
+template<typename S> void BasicFill<S>::initCoords(ArrayX2i const &coords) {
   // First build coords_ by excluding illegal pixels.
   constexpr int b   = 1; // Width (pixels) of illegal border.
   int const     rmin= b;
@@ -347,110 +1127,613 @@ void Fill::initCoords(ArrayX2i const &coords) {
     ++j;
   }
   coords_.conservativeResize(j, 2);
-  // Second, build coordsMap_.
-  ArrayXXi            cmap= ArrayXXi::Constant(hght_, wdth_, -1);
-  auto const          lin = coords_.col(0) + coords_.col(1) * hght_;
-  Eigen::Map<ArrayXi> m(&cmap(0, 0), hght_ * wdth_, 1);
-  m(lin)    = ArrayXi::LinSpaced(coords_.rows(), 0, coords_.rows() - 1);
-  coordsMap_= cmap;
 }
 
 
-Fill::Fill(ArrayX2i const &coords, unsigned width, unsigned height, bool cg):
+template<typename S> void BasicFill<S>::initLrtb() {
+  int const n= int(coords_.rows());
+  int const w= int(wdth_);
+  // Row-major offset of each filled pixel.
+  ArrayXi const off= coords_.col(0) * w + coords_.col(1);
+  vector<int>   order(n);
+  std::iota(order.begin(), order.end(), 0);
+  // Coordinates from mask are already in order.
+  if(!std::is_sorted(off.begin(), off.end())) {
+    std::stable_sort(order.begin(), order.end(), [&](int a, int b) {
+      return off(a) < off(b);
+    });
+  }
+  int const delta[]= {-1, +1, -w, +w}; // Left, right, top, bottom.
+  lrtb_.resize(n, 4);
+  for(int d= 0; d < 4; ++d) {
+    for(int k= 0, j= 0; k < n; ++k) {
+      int const i= order[k];
+      int const t= off(i) + delta[d];
+      while(j < n && off(order[j]) < t) ++j;
+      bool const filled= (j < n && off(order[j]) == t);
+      lrtb_(i, d)      = (filled ? order[j] : -1 - t);
+    }
+  }
+}
+
+
+template<typename S>
+BasicFill<S>::BasicFill(
+      ArrayX2i const &coords,
+      unsigned        width,
+      unsigned        height,
+      Method          method,
+      FactorCache<S> *cache):
     coords_(coords.rows(), coords.cols()),
     wdth_(width),
     hght_(height),
-    lrtb_(coords.rows(), 4),
-    a_(coords.rows(), coords.rows()),
-    cg_(cg) {
-  initCoords(coords); // Side effect is change of coords_.rows().
-  lrtb_.conservativeResize(coords_.rows(), 4);
-  lrtb_.col(0)= nLft();
-  lrtb_.col(1)= nRgt();
-  lrtb_.col(2)= nTop();
-  lrtb_.col(3)= nBot();
-  a_.conservativeResize(coords_.rows(), coords_.rows());
-  initMatrix();
+    method_(method) {
+  {
+    impl::Scope const s(rec_, COORDS);
+    initCoords(coords); // Side effect is change of coords_.rows().
+  }
+  init(cache);
 }
 
 
-template<typename Comp>
-ArrayX2i Fill::findCoords(Comp *m, unsigned w, unsigned h, int stride) {
-  Comp const zero(0);
-  // Width (pixels) of edge.
-  constexpr unsigned ew= 1;
+template<typename S>
+BasicFill<S>::BasicFill(
+      Interior,
+      impl::Recorder::Stamp scan,
+      ArrayX2i            &&coords,
+      unsigned              width,
+      unsigned              height,
+      Method                method,
+      FactorCache<S>       *cache):
+    coords_(std::move(coords)), wdth_(width), hght_(height), method_(method) {
+  rec_.add(SCAN, scan, impl::Recorder::now());
+  init(cache);
+}
+
+
+template<typename S> void BasicFill<S>::init(FactorCache<S> *cache) {
+  if(method_ == SOR) {
+    // Nothing but coordinates is needed.
+    impl::Scope const s(rec_, NEIGHBORS);
+    lrtb_.resize(0, 4);
+    compBegin_= ArrayXi::Zero(1);
+    initSor();
+    return;
+  }
+  {
+    impl::Scope const s(rec_, NEIGHBORS);
+    initLrtb();
+    initComponents();
+  }
+  bool const direct=
+        (method_ == CHOLESKY || method_ == CHOLESKY_MIXED || method_ == SCHUR);
+  if(!direct) {
+    impl::Scope const s(rec_, ASSEMBLY);
+    initGuess();
+  }
+  initMatrix(cache);
+}
+
+
+template<typename S>
+BasicFill<S>::BasicFill(string const &path):
+    file_(make_unique<impl::MappedFile>(path)), method_(CHOLESKY) {
+  char const *const data= file_->data();
+  std::size_t const size= file_->size();
+  std::size_t       off = 0;
+  // Take next `n` bytes from file, at next multiple of fileAlign.
+  auto const take= [&](std::size_t n) {
+    off= (off + fileAlign - 1) / fileAlign * fileAlign;
+    if(off > size || size - off < n) throw "Fill: truncated file";
+    char const *q= data + off;
+    off+= n;
+    return q;
+  };
+  // Every section is aligned, so that it may be used in place.
+  auto const ints= [&](std::size_t n) {
+    return reinterpret_cast<int const *>(take(n * sizeof(int)));
+  };
+  auto const scalars= [&](std::size_t n) {
+    return reinterpret_cast<S const *>(take(n * sizeof(S)));
+  };
+  // Copy next `a.size()` integers into `a`.
+  auto const copy= [&](auto &a) {
+    std::size_t const n= std::size_t(a.size()) * sizeof(int);
+    std::memcpy(a.data(), take(n), n);
+  };
+  FileHeader h;
+  std::memcpy(&h, take(sizeof(h)), sizeof(h));
+  if(std::memcmp(h.magic, "DIRFILL", 8)) throw "Fill: bad magic";
+  if(h.version != fileVersion) throw "Fill: unsupported version";
+  if(Method(h.method) != CHOLESKY) throw "Fill: unsupported method";
+  if(h.scalar != sizeof(S)) throw "Fill: unsupported scalar-type";
+  // Every index read from file is checked before use, so that corrupt or
+  // foreign file cannot make operator() reach outside caller's image.
+  auto const check= [](bool ok) {
+    if(!ok) throw "Fill: corrupt file";
+  };
+  // True if every one of `n` values at `v` be in `[lo, hi)`.
+  using std::size_t;
+  auto const within= [](int const *v, size_t n, int64_t lo, int64_t hi) {
+    return std::all_of(v, v + n, [=](int i) { return i >= lo && i < hi; });
+  };
+  check(h.width <= INT32_MAX && h.height <= INT32_MAX);
+  int const     n   = h.nCoords;
+  int64_t const npix= int64_t(h.width) * h.height;
+  check(n >= 0 && h.nComps >= 0 && n <= npix);
+  wdth_= h.width;
+  hght_= h.height;
+  coords_.resize(n, 2);
+  lrtb_.resize(n, 4);
+  compRows_.resize(n);
+  compBegin_.resize(std::size_t(h.nComps) + 1);
+  copy(coords_);
+  copy(lrtb_);
+  copy(compRows_);
+  copy(compBegin_);
+  check(within(coords_.col(0).data(), n, 0, hght_));
+  check(within(coords_.col(1).data(), n, 0, wdth_));
+  // Neighbor is either offset of filled pixel or `-1 - t`, where `t` is
+  // row-major offset of boundary-pixel in image.
+  check(within(lrtb_.data(), std::size_t(n) * 4, -npix, n));
+  check(within(compRows_.data(), n, 0, n));
+  check(compBegin_(0) == 0 && compBegin_(h.nComps) == n);
+  for(int c= 0; c < h.nComps; ++c) {
+    check(compBegin_(c) <= compBegin_(c + 1));
+  }
+  A_.resize(h.nComps);
+  for(int c= 0; c < h.nComps; ++c) {
+    int const *const sz   = ints(3);
+    int const        m    = sz[0];
+    int const        nnz  = sz[1];
+    check(m == compBegin_(c + 1) - compBegin_(c) && nnz >= 0);
+    int const *const outer= ints(std::size_t(m) + 1);
+    int const *const inner= ints(nnz);
+    S const         *value= scalars(nnz);
+    S const         *diag = scalars(m);
+    int const       *perm = (sz[2] ? ints(m) : nullptr);
+    check(outer[0] == 0 && outer[m] == nnz);
+    check(std::is_sorted(outer, outer + m + 1));
+    check(within(inner, nnz, 0, m));
+    check(!perm || within(perm, m, 0, m));
+    A_[c]= std::make_shared<impl::Ldlt<S> const>(
+          m, nnz, outer, inner, value, diag, perm);
+  }
+}
+
+
+template<typename S> void BasicFill<S>::save(string const &path) const {
+  if(method_ != CHOLESKY) throw "Fill::save: method is not Cholesky";
+  std::ofstream os(path, std::ios::binary);
+  if(!os) throw "Fill::save: cannot open file";
+  // Write `n` bytes at next multiple of fileAlign.
+  std::size_t off= 0;
+  auto const  put= [&](void const *d, std::size_t n) {
+    char const        zeros[fileAlign]= {};
+    std::size_t const pad= (fileAlign - off % fileAlign) % fileAlign;
+    os.write(zeros, pad);
+    os.write(static_cast<char const *>(d), n);
+    off+= pad + n;
+  };
+  FileHeader h{};
+  std::memcpy(h.magic, "DIRFILL", 8);
+  h.version= fileVersion;
+  h.method = method_;
+  h.scalar = sizeof(S);
+  h.width  = wdth_;
+  h.height = hght_;
+  h.nCoords= int32_t(coords_.rows());
+  h.nComps = components();
+  put(&h, sizeof(h));
+  put(coords_.data(), coords_.size() * sizeof(int));
+  put(lrtb_.data(), lrtb_.size() * sizeof(int));
+  put(compRows_.data(), compRows_.size() * sizeof(int));
+  put(compBegin_.data(), compBegin_.size() * sizeof(int));
+  for(auto const &f: A_) {
+    auto const l   = f->l();
+    auto const d   = f->d();
+    auto const perm= f->p();
+    int const  sz[]= {f->rows(), f->nonZeros(), perm.size() > 0};
+    put(sz, sizeof(sz));
+    put(l.outerIndexPtr(), (f->rows() + 1) * sizeof(int));
+    put(l.innerIndexPtr(), f->nonZeros() * sizeof(int));
+    put(l.valuePtr(), f->nonZeros() * sizeof(S));
+    put(d.data(), f->rows() * sizeof(S));
+    if(perm.size() > 0) put(perm.data(), f->rows() * sizeof(int));
+  }
+  if(!os) throw "Fill::save: cannot write file";
+}
+
+
+template<typename S>
+template<typename R>
+ArrayX2i BasicFill<S>::gather(unsigned w, unsigned h, R const &row) {
   // Ignore every pixel on edge of image.
-  if(h <= 2 * ew || w <= 2 * ew) return ArrayX2i();
-  ArrayX2i coords((h - 2 * ew) * (w - 2 * ew), 2);
-  // Walk the mask.
-  int i= 0;
-  for(unsigned r= ew; r < h - ew; ++r) {
-    Comp const *mask= m + (r * w + ew) * stride;
-    for(unsigned c= ew; c < w - ew; ++c) {
-      if(*mask != zero) {
-        coords.row(i)= Array2i{r, c};
-        ++i;
-      }
+  if(h <= 2 || w <= 2) return ArrayX2i();
+  int n= 0;
+  for(unsigned r= 1; r < h - 1; ++r) row(r, [&](int) { ++n; });
+  ArrayX2i coords(n, 2);
+  int      i= 0;
+  for(unsigned r= 1; r < h - 1; ++r) {
+    row(r, [&](int c) {
+      coords(i, 0)= int(r);
+      coords(i, 1)= c;
+      ++i;
+    });
+  }
+  return coords;
+}
+
+
+template<typename S>
+template<typename Comp>
+ArrayX2i
+BasicFill<S>::findCoords(Comp *m, unsigned w, unsigned h, int stride) {
+  using C= remove_const_t<Comp>;
+  if constexpr(sizeof(C) == 1 && is_integral_v<C>) {
+    if(stride == 1) {
+      auto const *const bytes= reinterpret_cast<uint8_t const *>(m);
+      return gather(w, h, [&](unsigned r, auto const &f) {
+        impl::forEachNonZero(bytes + std::size_t(r) * w, 1, int(w) - 1, f);
+      });
+    }
+  }
+  C const zero(0);
+  return gather(w, h, [&](unsigned r, auto const &f) {
+    Comp const *mask= m + (std::size_t(r) * w + 1) * stride;
+    for(unsigned c= 1; c < w - 1; ++c) {
+      if(*mask != zero) f(int(c));
       mask+= stride;
     }
+  });
+}
+
+
+template<typename S>
+ArrayX2i BasicFill<S>::findCoords(BitMask const &m, unsigned w, unsigned h) {
+  return gather(w, h, [&](unsigned r, auto const &f) {
+    impl::forEachSetBit(m.words + r * m.pitch, 1, int(w) - 1, f);
+  });
+}
+
+
+template<typename S>
+ArrayX2i
+BasicFill<S>::findCoords(vector<Run> const &runs, unsigned w, unsigned h) {
+  // Clip each run to interior.
+  auto const clip= [&](Run const &u, int &b, int &e) {
+    bool const in= (u.row >= 1 && u.row < int(h) - 1);
+    b            = std::max(u.col, 1);
+    e            = in ? std::min(u.col + u.length, int(w) - 1) : b;
+    return std::max(e - b, 0);
+  };
+  int n= 0;
+  int b, e;
+  for(Run const &u: runs) n+= clip(u, b, e);
+  ArrayX2i coords(n, 2);
+  int      i= 0;
+  for(Run const &u: runs) {
+    for(clip(u, b, e); b < e; ++b, ++i) {
+      coords(i, 0)= u.row;
+      coords(i, 1)= b;
+    }
   }
-  coords.conservativeResize(i, 2);
   return coords;
 }
 
 
+template<typename S>
 template<typename Comp>
-Fill::Fill(Comp *mask, unsigned width, unsigned height, int stride, bool cg):
-    Fill(findCoords(mask, width, height, stride), width, height, cg) {}
+BasicFill<S>::BasicFill(
+      Comp           *mask,
+      unsigned        width,
+      unsigned        height,
+      int             stride,
+      Method          method,
+      FactorCache<S> *cache):
+    // Braces evaluate arguments in order, so that scan is timed.
+    BasicFill{Interior(),
+              impl::Recorder::now(),
+              findCoords(mask, width, height, stride),
+              width,
+              height,
+              method,
+              cache} {}
+
+
+template<typename S>
+BasicFill<S>::BasicFill(
+      BitMask const  &mask,
+      unsigned        width,
+      unsigned        height,
+      Method          method,
+      FactorCache<S> *cache):
+    // Braces evaluate arguments in order, so that scan is timed.
+    BasicFill{Interior(),
+              impl::Recorder::now(),
+              findCoords(mask, width, height),
+              width,
+              height,
+              method,
+              cache} {}
+
+
+template<typename S>
+BasicFill<S>::BasicFill(
+      vector<Run> const &runs,
+      unsigned           width,
+      unsigned           height,
+      Method             method,
+      FactorCache<S>    *cache):
+    // Braces evaluate arguments in order, so that scan is timed.
+    BasicFill{Interior(),
+              impl::Recorder::now(),
+              findCoords(runs, width, height),
+              width,
+              height,
+              method,
+              cache} {}
+
+
+template<typename S> Stats BasicFill<S>::stats() const {
+  Stats st= rec_.stats();
+  st.nnzA = a_.nonZeros();
+  // Components of same shape share decomposition, which is counted once.
+  auto const distinct= [](auto f) {
+    std::sort(f.begin(), f.end());
+    f.erase(std::unique(f.begin(), f.end()), f.end());
+    int64_t n= 0;
+    for(auto const &d: f) n+= d->nonZeros();
+    return n;
+  };
+  st.nnzFactor= distinct(A_) + distinct(Af_);
+  if(schur_) st.nnzFactor+= schur_->nonZeros();
+  if(method_ == CG_ICHOL) {
+    st.nnzFactor+= IC_.preconditioner().matrixL().nonZeros();
+  }
+  return st;
+}
 
 
-template<typename Map> VectorXf Fill::solve(Map const &im) const {
+template<typename S>
+template<typename Map, typename L>
+void BasicFill<S>::solve(
+      Map const                         &im,
+      Workspace<Map::ColsAtCompileTime> &w,
+      int                               &iters,
+      L const                           &lay) const {
+  using Eigen::all;
   // First, calculate 1 for encoded offset; 0 for filled pixel.
   auto const fL= (lrtb_.col(0) < 0);
   auto const fR= (lrtb_.col(1) < 0);
   auto const fT= (lrtb_.col(2) < 0);
   auto const fB= (lrtb_.col(3) < 0);
   // Next, clamp offsets at zero on the low end.
-  auto const iL= fL.cast<int>() * (-lrtb_.col(0) - 1);
-  auto const iR= fR.cast<int>() * (-lrtb_.col(1) - 1);
-  auto const iT= fT.cast<int>() * (-lrtb_.col(2) - 1);
-  auto const iB= fB.cast<int>() * (-lrtb_.col(3) - 1);
-  // Next, calculate values.
-  auto const bL= fL.cast<float>() * im(iL).template cast<float>();
-  auto const bR= fR.cast<float>() * im(iR).template cast<float>();
-  auto const bT= fT.cast<float>() * im(iT).template cast<float>();
-  auto const bB= fB.cast<float>() * im(iB).template cast<float>();
+  auto const iL= lay(fL.cast<int>() * (-lrtb_.col(0) - 1));
+  auto const iR= lay(fR.cast<int>() * (-lrtb_.col(1) - 1));
+  auto const iT= lay(fT.cast<int>() * (-lrtb_.col(2) - 1));
+  auto const iB= lay(fB.cast<int>() * (-lrtb_.col(3) - 1));
+  // Next, calculate values for every component of each neighbor.
+  auto const start= impl::Recorder::now();
+  auto const vL= im(iL, all).template cast<S>();
+  auto const vR= im(iR, all).template cast<S>();
+  auto const vT= im(iT, all).template cast<S>();
+  auto const vB= im(iB, all).template cast<S>();
+  auto const bL= vL.colwise() * fL.template cast<S>();
+  auto const bR= vR.colwise() * fR.template cast<S>();
+  auto const bT= vT.colwise() * fT.template cast<S>();
+  auto const bB= vB.colwise() * fB.template cast<S>();
   // Now, pull pixel-data into b by evaluated vectorized expression.
-  VectorXf const b= bL + bR + bT + bB;
-  if(cg_) {
-    return CG_.solve(b);
-  } else {
-    return A_->solve(b);
+  w.b          = (bL + bR + bT + bB).matrix();
+  auto const &b= w.b;
+  auto       &x= w.x;
+  iters        = 0;
+  rec_.add(GATHER, start, impl::Recorder::now());
+  impl::Scope const s(rec_, SOLVE);
+  // Direct methods solve into `x` in place, so that workspace kept by
+  // caller is reused from image to image.
+  if(method_ == SCHUR) {
+    schur_->solve(b, x, w.schur);
+    return;
+  }
+  if(method_ == CHOLESKY) {
+    solveComponents<S>(A_, b, x);
+    return;
+  }
+  if(method_ == CHOLESKY_MIXED) {
+    // Solve in single precision, and then correct solution by solving in
+    // single precision for residual computed in S.  Each step gains roughly
+    // as many digits as single-precision solution has.
+    solveComponents<float>(Af_, b, x);
+    if(b.size() == 0) return;
+    S const eps  = Eigen::NumTraits<S>::dummy_precision();
+    S const bmax = b.cwiseAbs().maxCoeff();
+    S const limit= eps * bmax;
+    S       rmax = 0;
+    // Residual and correction, allocated once for every step.
+    Matrix<S, Dynamic, Map::ColsAtCompileTime> r, dx;
+    for(; iters < maxRefinements; ++iters) {
+      r= b;
+      r.noalias()-= a_ * x;
+      rmax= r.cwiseAbs().maxCoeff();
+      if(rmax <= limit) break;
+      solveComponents<float>(Af_, r, dx);
+      x+= dx;
+    }
+    rec_.converged(iters, bmax > 0 ? double(rmax / bmax) : 0.0);
+    return;
   }
+  // Start iteration from interpolation across hole rather than from zero.
+  x    = guess(im, lay);
+  S err= 0;
+  switch(method_) {
+  case CG: iters= cg(CG_, a_, b, x, w, err); break;
+  case CG_AMG: iters= cg(AMG_, a_, b, x, w, err); break;
+  case CG_ICHOL: iters= cg(IC_, a_, b, x, w, err); break;
+  default: iters= cg(MF_, lap_, b, x, w, err); break;
+  }
+  rec_.converged(iters, double(err));
 }
 
 
-template<typename Map>
-void Fill::copySolutionBackIntoImage(Map &im, VectorXf const &x) const {
+template<typename S>
+template<typename C, typename M, typename B, typename X, typename W>
+int BasicFill<S>::cg(
+      C const &cg, M const &m, B const &b, X &x, W &w, S &err) {
+  // Same iteration as C::solveWithGuess(), so that count of iterations is
+  // unchanged, but without writing count and error into solver.
+  S const   tol = cg.tolerance();
+  S const   tiny= std::numeric_limits<S>::min();
+  int const cap = int(cg.maxIterations());
+  auto     &r   = w.r;
+  auto     &z   = w.z;
+  auto     &p   = w.p;
+  auto     &q   = w.q;
+  int       most= 0;
+  err           = 0;
+  for(Eigen::Index k= 0; k < b.cols(); ++k) {
+    auto    xk  = x.col(k);
+    S const bb  = b.col(k).squaredNorm();
+    S const stop= std::max(tol * tol * bb, tiny);
+    if(bb == S(0)) {
+      xk.setZero();
+      continue;
+    }
+    q.noalias()= m * xk;
+    r          = b.col(k) - q;
+    S   rr     = r.squaredNorm();
+    int it     = 0;
+    if(rr >= stop) {
+      z   = cg.preconditioner().solve(r);
+      p   = z;
+      S rz= r.dot(z);
+      for(; it < cap; ++it) {
+        q.noalias()  = m * p;
+        S const alpha= rz / p.dot(q);
+        xk+= alpha * p;
+        r-= alpha * q;
+        rr= r.squaredNorm();
+        if(rr < stop) break;
+        z        = cg.preconditioner().solve(r);
+        S const o= rz;
+        rz       = r.dot(z);
+        p        = z + (rz / o) * p;
+      }
+    }
+    most= std::max(most, it);
+    err = std::max(err, std::sqrt(rr / bb));
+  }
+  return most;
+}
+
+
+template<typename S>
+template<typename F, typename B, typename X>
+void BasicFill<S>::solveComponents(
+      vector<typename FactorCache<F>::Factor> const &f,
+      B const                                       &b,
+      X                                             &x) const {
+  using Eigen::all;
+  using Rhs= Matrix<F, Dynamic, B::ColsAtCompileTime>;
+  x.resize(b.rows(), b.cols());
+  impl::ThreadPool::global().run(components(), [&](int c) {
+    int const  n   = compBegin_(c + 1) - compBegin_(c);
+    auto const rows= compRows_.segment(compBegin_(c), n);
+    Rhs const  bc  = b(rows, all).template cast<F>();
+    // Solve for all columns in one pass over factor.
+    x(rows, all)= f[c]->solve(bc).template cast<S>();
+  });
+}
+
+
+template<typename S>
+template<typename Map, typename L>
+Matrix<S, Dynamic, Map::ColsAtCompileTime>
+BasicFill<S>::guess(Map const &im, L const &lay) const {
+  using Eigen::all;
+  auto const gL= im(lay(guessOff_.col(0)), all).template cast<S>();
+  auto const gR= im(lay(guessOff_.col(1)), all).template cast<S>();
+  auto const gT= im(lay(guessOff_.col(2)), all).template cast<S>();
+  auto const gB= im(lay(guessOff_.col(3)), all).template cast<S>();
+  auto const wL= gL.colwise() * guessWgt_.col(0);
+  auto const wR= gR.colwise() * guessWgt_.col(1);
+  auto const wT= gT.colwise() * guessWgt_.col(2);
+  auto const wB= gB.colwise() * guessWgt_.col(3);
+  return (wL + wR + wT + wB).matrix();
+}
+
+
+template<typename S>
+template<typename Map, typename L>
+void BasicFill<S>::sor(Map &im, int &sweeps, L const &lay) const {
+  using T= remove_const_t<typename Map::CompType>;
+  impl::Scope const s(rec_, SOLVE);
+  // Enough pixels in each chunk to amortize handing it out.
+  constexpr int chunk= 4096;
+  int const     dc   = lay(1);         // Offset from pixel to next.
+  int const     dr   = lay(int(wdth_)); // Offset from row to next.
+  int const     n    = int(sorOff_.size());
+  T const       om   = T(omega_);
+  vector<T>     change((n + chunk - 1) / chunk + 1);
+  vector<T>     scale(change.size());
+  for(sweeps= 0; sweeps < maxSweeps_;) {
+    T dmax= 0, vmax= 0;
+    for(int color= 0; color < 2; ++color) {
+      int const b = (color == 0 ? 0 : sorRed_);
+      int const e = (color == 0 ? sorRed_ : n);
+      int const nc= (e - b + chunk - 1) / chunk;
+      impl::ThreadPool::global().run(nc, [&](int c) {
+        int const end= std::min(b + (c + 1) * chunk, e);
+        T         d  = 0;
+        T         s  = 0;
+        for(int k= b + c * chunk; k < end; ++k) {
+          int const p= lay(sorOff_(k));
+          T const   g= (im(p - dc) + im(p + dc) + im(p - dr) + im(p + dr)) / 4;
+          T const   u= om * (g - im(p));
+          im(p)+= u;
+          d= std::max(d, std::abs(u));
+          s= std::max(s, std::abs(g));
+        }
+        change[c]= d;
+        scale[c] = s;
+      });
+      for(int c= 0; c < nc; ++c) {
+        dmax= std::max(dmax, change[c]);
+        vmax= std::max(vmax, scale[c]);
+      }
+    }
+    ++sweeps;
+    rec_.converged(sweeps, vmax > 0 ? double(dmax / vmax) : 0.0);
+    if(dmax <= T(tol_) * vmax) break;
+  }
+}
+
+
+template<typename S>
+template<typename Map, typename X, typename L>
+void BasicFill<S>::copySolutionBackIntoImage(
+      Map &im, X const &x, L const &lay) const {
   using Comp                = typename Map::CompType;
   constexpr bool is_integral= is_integral_v<Comp>;
+  using Eigen::all;
+  impl::Scope const s(rec_, WRITE_BACK);
   // Image is row-major.
-  auto const ii= /*col*/ coords_.col(0) * wdth_ + /*row*/ coords_.col(1);
+  auto const ii= lay(/*col*/ coords_.col(0) * wdth_ + /*row*/ coords_.col(1));
   if constexpr(is_integral) {
     if constexpr(is_unsigned_v<Comp>) {
-      im(ii)= (x.array() + 0.5f).cast<Comp>();
+      im(ii, all)= (x.array() + S(0.5)).template cast<Comp>();
     } else {
-      auto const neg= (x.array() < 0.0f).cast<Comp>();
-      auto const rup= (x.array() + 0.5f).cast<Comp>();
-      auto const rdn= (x.array() - 0.5f).cast<Comp>();
+      auto const neg= (x.array() < S(0)).template cast<Comp>();
+      auto const rup= (x.array() + S(0.5)).template cast<Comp>();
+      auto const rdn= (x.array() - S(0.5)).template cast<Comp>();
       // Round in correct direction.
-      im(ii)= neg * rdn + (Comp(1) - neg) * rup;
+      im(ii, all)= neg * rdn + (Comp(1) - neg) * rup;
     }
   } else {
-    if constexpr(is_same_v<float, Comp>) {
-      im(ii)= x.array();
+    if constexpr(is_same_v<S, Comp>) {
+      im(ii, all)= x.array();
     } else {
-      im(ii)= x.array().cast<Comp>();
+      im(ii, all)= x.array().template cast<Comp>();
     }
   }
 }
@@ -461,8 +1744,14 @@ void Fill::copySolutionBackIntoImage(Map &im, VectorXf const &x) const {
 /// Single-component image *appears* as if it were of this type, regardless of
 /// how component is stored relative to other components in same image.
 ///
+/// When `Comp` is const type, Image is const array.
+///
 /// \tparam Comp  Type of each color-component in image.
-template<typename Comp> using Image= Array<Comp, Dynamic, 1>;
+template<typename Comp>
+using Image= conditional_t<
+      is_const_v<Comp>,
+      Array<remove_const_t<Comp>, Dynamic, 1> const,
+      Array<Comp, Dynamic, 1>>;
 
 
 /// Allow run-time (Eigen::Dynamic) stride in map for single-component,
@@ -494,19 +1783,200 @@ struct Map: public Eigen::Map<Image<Comp>, Unaligned, ImageStride> {
 };
 
 
+/// Type to which multiple-component image is mapped.
+///
+/// Each row is pixel, and each column is component of pixel.  When `Comp` is
+/// const type, Channels is const array.
+///
+/// \tparam Comp  Type of each color-component in image.
+template<typename Comp>
+using Channels= conditional_t<
+      is_const_v<Comp>,
+      Array<remove_const_t<Comp>, Dynamic, Dynamic, RowMajor> const,
+      Array<Comp, Dynamic, Dynamic, RowMajor>>;
+
+
+/// Allow run-time (Eigen::Dynamic) stride between pixels in map for
+/// multiple-component, row-major image.
+using ChannelsStride= Eigen::OuterStride<Dynamic>;
+
+
+/// Descend from Eigen::Map to provide access to type of image-component.
+/// \tparam Comp  Type of each color-component in image.
 template<typename Comp>
-VectorXf Fill::operator()(Comp *image, int stride) const {
+struct ChannelsMap:
+    public Eigen::Map<Channels<Comp>, Unaligned, ChannelsStride> {
+  /// Type of ancestor.
+  using P= Eigen::Map<Channels<Comp>, Unaligned, ChannelsStride>;
+
+  /// Type of each color-component in image.
+  using CompType= Comp;
+
+  /// Initialize ancestor.
+  ///
+  /// \param image   Pointer to first component of first pixel.
+  /// \param pixels  Number of pixels in image.
+  /// \param comps   Number of components mapped in each pixel.
+  ///
+  /// \param stride  Number of instances of `Comp` between first component of
+  ///                one pixel and first component of next pixel.
+  ///
+  ChannelsMap(
+        Comp                 *image,
+        unsigned              pixels,
+        unsigned              comps,
+        ChannelsStride const &stride):
+      P(image, pixels, comps, stride) {}
+};
+
+
+template<typename S>
+template<typename Comp>
+Matrix<S, Dynamic, 1> BasicFill<S>::operator()(Comp *image, int stride) const {
   Map im(image, int(hght_ * wdth_), 1, ImageStride(1, stride));
+  constexpr bool is_const   = is_const_v<Comp>;
+  constexpr bool is_integral= is_integral_v<Comp>;
+  constexpr bool is_fp      = is_floating_point_v<Comp>;
+  if(method_ == SOR) {
+    if constexpr(!is_const && is_fp) {
+      int it= 0;
+      sor(im, it);
+      iterations_  = it;
+      auto const ii= coords_.col(0) * wdth_ + coords_.col(1);
+      return im(ii).template cast<S>();
+    } else {
+      throw "SOR requires non-const, floating-point image";
+    }
+  }
   // Find solution.
-  VectorXf const x= solve(im);
+  Workspace<1> w;
+  int          it= 0;
+  solve(im, w, it);
+  iterations_= it;
+  // If possible, copy solution back into original image.
+  if constexpr(!is_const && (is_integral || is_fp)) {
+    copySolutionBackIntoImage(im, w.x);
+  }
+  return std::move(w.x);
+}
+
+
+template<typename S>
+template<typename Comp>
+Matrix<S, Dynamic, Dynamic>
+BasicFill<S>::operator()(Comp *image, int stride, int nComp) const {
+  if(nComp > stride) throw "more components than stride";
+  if(method_ == SOR) {
+    if constexpr(!is_const_v<Comp> && is_floating_point_v<Comp>) {
+      // Relax each component in place.
+      Matrix<S, Dynamic, Dynamic> x(coords_.rows(), nComp);
+      auto const ii  = coords_.col(0) * wdth_ + coords_.col(1);
+      int        most= 0;
+      for(int k= 0; k < nComp; ++k) {
+        Map im(image + k, int(hght_ * wdth_), 1, ImageStride(1, stride));
+        int it= 0;
+        sor(im, it);
+        x.col(k)= im(ii).template cast<S>();
+        most    = std::max(most, it);
+      }
+      iterations_= most;
+      return x;
+    } else {
+      throw "SOR requires non-const, floating-point image";
+    }
+  }
+  ChannelsMap im(image, hght_ * wdth_, nComp, ChannelsStride(stride));
+  // Find solution for every component at once.
+  Workspace<Dynamic> w;
+  int                it= 0;
+  solve(im, w, it);
+  iterations_= it;
   // If possible, copy solution back into original image.
   constexpr bool is_const   = is_const_v<Comp>;
   constexpr bool is_integral= is_integral_v<Comp>;
   constexpr bool is_fp      = is_floating_point_v<Comp>;
   if constexpr(!is_const && (is_integral || is_fp)) {
-    copySolutionBackIntoImage(im, x);
+    copySolutionBackIntoImage(im, w.x);
   }
-  return x;
+  return std::move(w.x);
+}
+
+
+template<typename S>
+template<typename Comp>
+Matrix<S, Dynamic, Dynamic>
+BasicFill<S>::operator()(Comp *canvas, View const &view, int nComp) const {
+  if(nComp > view.stride) throw "more components than stride";
+  Comp *const   image= canvas + view.row * view.pitch + view.col * view.stride;
+  Pitched const lay{int(wdth_), view.pitch, view.stride};
+  // Every component of every pixel in image lies within extent.
+  int const extent= lay(int(hght_ * wdth_) - 1) + 1;
+  if(method_ == SOR) {
+    if constexpr(!is_const_v<Comp> && is_floating_point_v<Comp>) {
+      // Relax each component in place.
+      Matrix<S, Dynamic, Dynamic> x(coords_.rows(), nComp);
+      auto const ii  = lay(coords_.col(0) * wdth_ + coords_.col(1));
+      int        most= 0;
+      for(int k= 0; k < nComp; ++k) {
+        Map im(image + k, extent, 1, ImageStride(1, 1));
+        int it= 0;
+        sor(im, it, lay);
+        x.col(k)= im(ii).template cast<S>();
+        most    = std::max(most, it);
+      }
+      iterations_= most;
+      return x;
+    } else {
+      throw "SOR requires non-const, floating-point image";
+    }
+  }
+  // Each row of map is component in canvas, so that offset from lay is row.
+  ChannelsMap im(image, extent, nComp, ChannelsStride(1));
+  Workspace<Dynamic> w;
+  int                it= 0;
+  solve(im, w, it, lay);
+  iterations_= it;
+  // If possible, copy solution back into canvas.
+  constexpr bool is_const   = is_const_v<Comp>;
+  constexpr bool is_integral= is_integral_v<Comp>;
+  constexpr bool is_fp      = is_floating_point_v<Comp>;
+  if constexpr(!is_const && (is_integral || is_fp)) {
+    copySolutionBackIntoImage(im, w.x, lay);
+  }
+  return std::move(w.x);
+}
+
+
+template<typename S>
+template<typename It>
+void BasicFill<S>::batch(It begin, It end, int stride, int nComp) const {
+  using Comp= std::remove_pointer_t<
+        typename std::iterator_traits<It>::value_type>;
+  static_assert(!is_const_v<Comp>, "batch() writes into each image");
+  if(nComp > stride) throw "more components than stride";
+  if constexpr(!is_floating_point_v<Comp>) {
+    if(method_ == SOR) throw "SOR requires non-const, floating-point image";
+  }
+  impl::ThreadPool &pool= impl::ThreadPool::global();
+  // One workspace for each thread that might run task.
+  vector<Workspace<Dynamic>> ws(pool.size());
+  pool.run(int(end - begin), [&](int i) {
+    Comp *const image= begin[i];
+    int         iters= 0;
+    if(method_ == SOR) {
+      if constexpr(is_floating_point_v<Comp>) {
+        for(int k= 0; k < nComp; ++k) {
+          Map im(image + k, hght_ * wdth_, 1, ImageStride(1, stride));
+          sor(im, iters);
+        }
+      }
+      return;
+    }
+    ChannelsMap im(image, hght_ * wdth_, nComp, ChannelsStride(stride));
+    Workspace<Dynamic> &w= ws[impl::ThreadPool::slot()];
+    solve(im, w, iters);
+    copySolutionBackIntoImage(im, w.x);
+  });
 }
 
 
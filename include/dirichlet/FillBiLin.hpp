@@ -5,12 +5,19 @@
 #ifndef DIRICHLET_FILL_BILIN_HPP
 #define DIRICHLET_FILL_BILIN_HPP
 
+#include "../df/BinPrep.hpp"    // minMult()
+#include "Stats.hpp"            // Stats
+#include "impl/MaskPyramid.hpp" // MaskPyramid
+#include "impl/Recorder.hpp"    // Recorder
 #include "impl/Weights.hpp"     // Weights
-#include "impl/bin2x2.hpp"      // bin2x2()
-#include "impl/unbin2x2.hpp"    // unbin2x2()
-#include "impl/validSquare.hpp" // validSquare()
+#include "impl/edt.hpp"         // edt()
+#include <algorithm>            // stable_sort
+#include <cmath>                // sqrt
 #include <eigen3/Eigen/Sparse>  // SparseMatrix
 #include <iostream>             // cout, endl
+#include <limits>               // numeric_limits
+#include <ostream>              // ostream
+#include <vector>               // vector
 
 namespace dirichlet {
 
@@ -18,6 +25,7 @@ namespace dirichlet {
 using Eigen::Array3;
 using Eigen::ArrayX2i;
 using Eigen::ArrayX3;
+using Eigen::ArrayX3i;
 using Eigen::ArrayXi;
 using Eigen::ArrayXX;
 using Eigen::ArrayXXi;
@@ -29,6 +37,18 @@ using std::cerr;
 using std::endl;
 
 
+/// Placement of squares, across each of which FillBiLin interpolates.
+enum Placement {
+  /// Squares on grid of each power-of-two binning, as found by recursive
+  /// binning of mask.
+  ALIGNED,
+
+  /// Largest squares that fit, at any offset, centered where distance to
+  /// boundary is greatest.
+  DEEPEST
+};
+
+
 /// Fill holes in image by approximately solving Dirichlet-problem for
 /// zero-valued Laplacian across hole-pixels.
 ///
@@ -44,9 +64,13 @@ using std::endl;
 /// image and pixels to be filled.
 ///
 /// Instance is function-object that solves linear problem by analyzing
-/// image-data.
+/// image-data.  Solution modifies no member, so that several threads may fill
+/// images through one instance, each with its own Workspace.
 class FillBiLin {
-  /// Left, right, top, bottom, and center weights for each pixel.
+  int h_; ///< Height of image.
+  int w_; ///< Width  of image.
+
+  /// Left, right, top, bottom, and center weights for each unknown.
   impl::Weights weights_;
 
   /// Number of squares over which to interpolate.
@@ -55,9 +79,20 @@ class FillBiLin {
   /// Number of pixels, each of whose values is solved for in linear problem.
   int nSolvePix_= 0;
 
+  /// Largest estimated error of interpolation that any square may have,
+  /// relative to range of boundary-values.
+  float maxError_;
+
+  /// Largest estimated error among squares registered.
+  float error_= 0.0f;
+
+  /// Squared distance from each pixel to boundary, kept only during
+  /// construction, and only if `maxError_` be finite.
+  ArrayXXi depth2_;
+
   /// Corner-coordinates and side-length for each square over which to
   /// interpolate.
-  ArrayX3<int16_t> corners_;
+  ArrayX3i corners_;
 
   /// See documentation for extendedMask().
   ArrayXX<bool> extendedMask_;
@@ -70,30 +105,63 @@ class FillBiLin {
   // corresponding row-offset of same coordinates in `coords_`.
   ArrayXXi coordsMap_;
 
-  /// Square matrix for linear problem.
+  /// Square matrix for linear problem, which is symmetric and
+  /// positive-definite.
   SparseMatrix<float> a_;
 
   /// Pointer to Cholesky-decomposition of square matrix for linear problem.
   SimplicialCholesky<SparseMatrix<float>> *A_= nullptr;
 
-  VectorXf b_;
+  /// Contribution of one boundary-pixel to right-hand side.
+  struct Gather {
+    int   unknown; ///< Offset of unknown in `coords_`.
+    int   row;     ///< Row    of boundary-pixel in image.
+    int   col;     ///< Column of boundary-pixel in image.
+    float weight;  ///< Weight of boundary-pixel in unknown's row.
+  };
+
+  /// Every contribution of boundary-pixel to right-hand side, in order of
+  /// unknown.  None depends on pixel-values, so that list is made once, by
+  /// initMatrix(), and solve() need not examine `coordsMap_`.
+  std::vector<Gather> gather_;
+
+  /// Time spent in each phase.  Records nothing unless DIRICHLET_STATS be
+  /// defined.
+  mutable impl::Recorder rec_;
+
+  /// Largest binning factor reached by binMask().
+  ///
+  /// Mask is not padded to multiple of this factor.  Each level of binning
+  /// has half (rounded down) rows and columns of level below, and odd last
+  /// row or column is left out, as it could not be in any square at that
+  /// level.  So no level is larger than image, whatever size of image be.
+  ///
+  /// \param h  Height of image.
+  /// \param w  Width  of image.
+  /// \return   Largest binning factor.
+  static int maxBinFactor(int h, int w) {
+    int f= 4;
+    while(df::minMult(h, f) / f >= 8 && df::minMult(w, f) / f >= 8) f*= 2;
+    return f;
+  }
 
-  /// Extend mask with with zeros so that it is power of two along each
-  /// dimension, and convert to array of boolean.
+  /// Convert mask to array of boolean, of same size as image.
   /// \tparam P       Type of each pixel-value in mask.
   /// \param  msk     Pointer to first pixel of row-major mask-image.
   /// \param  stride  Pointer-increments between consecutive pixels.
   template<typename P> void extendMask(P const *msk, int stride);
 
-  /// Modify `weights_` for corners and edges of square to interpolate, add
-  /// entry to `corners_`, increment `nSquares_`, and set false in
-  /// `extendedMask_` every pixel corresponding to square.
-  /// \param r   Row of valid pixel at binning-factor bf in binMask().
-  /// \param c   Col of valid pixel at binning-vactor bf in binMask().
-  /// \param bf  Absolute binning factor relative to unbinned mask.
-  void registerSquare(int r, int c, int bf);
-
-  /// Modify `weights_` for corners and edges of square to interpolate.
+  /// Add entry to `corners_`, increment `nSquares_`, set false in
+  /// `extendedMask_` every pixel corresponding to square, and mark square in
+  /// `coordsMap_`.
+  /// \param top  Top  unbinned row.
+  /// \param lft  Left unbinned column.
+  /// \param n    Number of pixels along side of square.
+  void registerSquare(int top, int lft, int n);
+
+  /// Set `weights_` for corners and edges of square to interpolate.  Each
+  /// pixel on perimeter of square must already have its offset in
+  /// `coordsMap_`.
   /// \param top  Top    unbinned row.
   /// \param lft  Left   unbinned column.
   /// \param bot  Bottom unbinned row.
@@ -107,63 +175,105 @@ class FillBiLin {
   /// \param rgt  Right  unbinned column.
   void eliminateSquareFromMask(int top, int lft, int bot, int rgt);
 
-  template<typename T> void registerSquares(T const &valid, int bf) {
-    for(int c= 0; c < valid.cols(); ++c) {
-      for(int r= 0; r < valid.rows(); ++r) {
-        if(valid(r, c)) registerSquare(r, c, bf);
+  /// Estimated largest error of bilinear interpolation across square,
+  /// relative to range of boundary-values.
+  ///
+  /// Second derivative of harmonic function falls off as inverse square of
+  /// distance to boundary, and error of interpolation grows as square of size
+  /// of square, so that estimate is `errorScale * n^2 / d^2`, where `d` is
+  /// least distance from perimeter of square to boundary.
+  ///
+  /// \param top  Top  unbinned row.
+  /// \param lft  Left unbinned column.
+  /// \param n    Number of pixels along side of square.
+  /// \return     Estimated error, or zero if there be no budget.
+  float squareError(int top, int lft, int n) const;
+
+  /// Register each valid square whose estimated error is within budget.
+  /// Words with no valid square are skipped whole.
+  /// \param valid  Valid squares at binning-factor bf in binMask().
+  /// \param bf     Absolute binning factor relative to unbinned mask.
+  /// \param taken  Squares already taken, to which each square registered is
+  ///               added.
+  void registerSquares(
+        impl::MaskPyramid::Level const &valid,
+        int                             bf,
+        impl::MaskPyramid::Level       &taken) {
+    using Word= impl::MaskPyramid::Word;
+    for(int r= 0; r < valid.rows; ++r) {
+      Word const *v= valid.row(r);
+      Word       *t= taken.row(r);
+      for(int k= 0; k < valid.pitch; ++k) {
+        for(Word w= v[k] & ~t[k]; w; w&= w - 1) {
+          int const   c= k * 64 + __builtin_ctzll(w);
+          float const e= squareError(r * bf, c * bf, bf);
+          if(e > maxError_) continue;
+          error_= std::max(error_, e);
+          t[k]|= Word(1) << (c % 64);
+          registerSquare(r * bf, c * bf, bf);
+        }
       }
     }
   }
 
-  /// Recursive function that performs binning on higher-resolution mask `hi`,
-  /// detects valid squares at current binning level, calls itself (if enough
-  /// pixels at current binning), modifies `weights_` for corners and edges of
-  /// squares to interpolate, increments `nSquares_` as needed, modifies
-  /// `corners_` as needed, and returns result of next-lower-resolution
-  /// binning.
+  /// Place squares from coarsest level of binning to finest.  Every level of
+  /// binning is built, bit-packed, in one pass over rows of caller's mask,
+  /// which is row-major, and valid squares are found a word at a time.  At
+  /// each level, square is registered only where no larger square was taken
+  /// at coarser level.
   ///
-  /// \param  hi  Higher-resolution mask.
-  /// \param  bf  Absolute binning factor of lo relative to unbinned mask.
-  /// \return     Squares taken at next lower resolution.
+  /// Square too large for budget of error is left to smaller squares at
+  /// higher resolution.
   ///
-  ArrayXX<bool> binMask(ArrayXX<bool> const &hi, int bf) {
-    // Bin to current level.
-    auto const lo= impl::bin2x2(hi);
-    auto const nr= lo.rows();
-    auto const nc= lo.cols();
-    // Identify interpolable squares at current level.
-    auto const loValid= impl::validSquare(lo);
-    // Make recursive call only if enough interpolable squares.
-    if(nr >= 8 && nc >= 8) {
-      // Make recursive call.
-      registerSquares(loValid && !impl::unbin2x2(binMask(lo, bf * 2)), bf);
-    } else {
-      registerSquares(loValid, bf);
-    }
-    return loValid;
-  }
-
-  /// After binMask() is done, constructor calls this to set, if necessary,
-  /// weights for each image-corner pixel whose value is to be solved for.
-  /// \param h  Height of image.
-  /// \param w  Width  of image.
-  void populateCornerWeights(int h, int w);
-
-  /// After binMask() is done, constructor calls this to set, if necessary,
-  /// weights for each image-edge pixel whose value is to be solved for.
-  /// \param h  Height of image.
-  /// \param w  Width  of image.
-  void populateEdgeWeights(int h, int w);
+  /// \tparam P       Type of each pixel-value in mask.
+  /// \param  msk     Pointer to first pixel of row-major mask-image.
+  /// \param  stride  Pointer-increments between consecutive pixels.
+  template<typename P> void binMask(P const *msk, int stride);
 
-  /// After binMask() is done, constructor calls this to set, if necessary,
-  /// weights for each interior image-pixel whose value is to be solved for and
-  /// which has not already had its weights set by way of its assocation with
-  /// the perimter of a square marked for interpolation.
-  /// \param h  Height of image.
-  /// \param w  Width  of image.
-  void populateInteriorWeights(int h, int w);
+  /// Alternative to binMask() for DEEPEST placement.  Visit pixels of mask in
+  /// order of decreasing Euclidean distance to boundary, and, at each pixel
+  /// not yet in square, register largest square centered there that fits.
+  ///
+  /// Square fits if every pixel in it and every neighbor of such pixel be in
+  /// mask, so that no pixel on edge of square touches boundary or edge of
+  /// image, and if it overlap no square already registered.
+  void placeSquares();
+
+  /// After `coords_` and `coordsMap_` are done, initMatrix() calls this to
+  /// set weights for each unknown.  Pixel outside every square has unit
+  /// weight for each neighbor in image, and pixel on perimeter of square has
+  /// weights from registerSquareWeights().
+  void initWeights();
+
+  /// Factor by which registerSquareWeights() multiplies weights of pixel on
+  /// edge of square.  Dividing pixel's row by this factor makes matrix
+  /// symmetric, for weight `s` along edge of square then matches weight one
+  /// of neighbor across edge, and weight one across square matches weight one
+  /// of pixel on opposite edge.
+  /// \param cw  Center-weight of pixel.
+  /// \return    Distance across square for pixel on edge of square; otherwise,
+  ///            one.
+  static int rowScale(int cw) { return cw < -4 ? (-cw - 1) / 3 : 1; }
+
+  /// After `weights_` are done, initMatrix() calls this to list, in
+  /// `gather_`, every contribution of boundary-pixel to right-hand side.
+  void initGather();
 
-  template<typename I> VectorXf solve(I const &im);
+public:
+  /// Right-hand side and solution for one image.  Thread that keeps its own
+  /// from image to image shares decomposition with other threads and does not
+  /// allocate anew for each image.
+  struct Workspace {
+    VectorXf b; ///< Right-hand side.
+    VectorXf x; ///< Solution.
+  };
+
+private:
+  /// Calculate solution to linear system.
+  /// \tparam I   Type of single-component image.
+  /// \param  im  Reference to single-component image.
+  /// \param  ws  Workspace; on return, `ws.x` is solution to linear system.
+  template<typename I> void solve(I const &im, Workspace &ws) const;
 
   /// Copy solution back into original image.
   /// \tparam I      Type of single-component image.
@@ -172,6 +282,13 @@ class FillBiLin {
   template<typename I>
   void copySolutionBackIntoImage(I &im, VectorXf const &x) const;
 
+  /// Fill interior of each square in corners() by bilinear interpolation
+  /// between solved values at square's corners.
+  /// \tparam I      Type of single-component image.
+  /// \param  image  Reference to single-component image.
+  /// \param  x      Solution.
+  template<typename I> void fillSquares(I &im, VectorXf const &x) const;
+
 public:
   /// Set up linear problem by analyzing mask.
   /// \tparam P       Type of each pixel-value in mask.
@@ -179,7 +296,19 @@ public:
   /// \param  w       Width of image.
   /// \param  h       Height of image.
   /// \param  stride  Pointer-increments between consecutive pixels.
-  template<typename P> FillBiLin(P const *msk, int w, int h, int stride= 1);
+  /// \param  place   Placement of squares.
+  /// \param  error   Largest estimated error of interpolation that any square
+  ///                 may have, relative to range of boundary-values.  Smaller
+  ///                 budget gives smaller squares, more unknowns, and solution
+  ///                 closer to that of Fill.  Infinite budget places squares
+  ///                 by geometry alone.
+  template<typename P>
+  FillBiLin(P const  *msk,
+            int       w,
+            int       h,
+            int       stride= 1,
+            Placement place = ALIGNED,
+            float     error = std::numeric_limits<float>::infinity());
 
   /// Deallocate Cholesky-docomposition.
   virtual ~FillBiLin() {
@@ -191,29 +320,42 @@ public:
 
   /// Width of image.
   /// \return  Width of image.
-  int w() const { return weights_.w(); }
+  int w() const { return w_; }
 
   /// Height of image.
   /// \return  Height of image.
-  int h() const { return weights_.h(); }
+  int h() const { return h_; }
 
-  /// Left, right, top, bottom, and center weights for each pixel.
+  /// Left, right, top, bottom, and center weights for each unknown, in same
+  /// order as coords().
   ///
-  /// For each pixel not to be filled, each weight is zero.  For each pixel to
-  /// be filled by interpolant, each weight is zero.  For each pixel along edge
-  /// of square to interpolate, weights represent one-dimensional Laplacian,
-  /// with nonzero weights only along edge (and zero weights perpendicular to
-  /// edge).  For each pixel along edge of image, weights correspond to mean of
+  /// For each pixel along edge of square to interpolate, weight along edge is
+  /// side of square, and weight across square refers to pixel on opposite
+  /// edge.  For each pixel along edge of image, weights correspond to mean of
   /// available neighbors.  Otherwise, for pixel whose value is to be solved
   /// for in region to be filled, weights correspond to mean of pixel.
   ///
-  /// \return  Left, right, top, bottom, and center weights for each pixel.
+  /// \return  Left, right, top, bottom, and center weights for each unknown.
   impl::Weights const &weights() const { return weights_; }
 
   /// Number of squares over which to interpolate.
   /// \return  Number of squares over which to interpolate.
   int nSquares() const { return nSquares_; }
 
+  /// Number of unknowns in linear problem.
+  /// \return  Number of unknowns in linear problem.
+  int nUnknowns() const { return nSolvePix_; }
+
+  /// Largest estimated error of interpolation among squares, relative to
+  /// range of boundary-values.  See squareError().
+  /// \return  Largest estimated error among squares.
+  float estimatedError() const { return error_; }
+
+  /// Scale of estimate in squareError().  Against solution of Fill across
+  /// holes with boundary-values of various angular frequency, actual error
+  /// relative to range is between two and ten times smaller than budget.
+  static constexpr float errorScale= 0.5f;
+
   /// Array with three columns, two for coordinates of top-left pixel of each
   /// square over which to interpolate and one for number of pixels along side
   /// of square.
@@ -224,7 +366,7 @@ public:
   ///
   /// \return  Corner-coordinates and side-length for each square over which to
   ///          interpolate.
-  ArrayX3<int16_t> const &corners() const { return corners_; }
+  ArrayX3i const &corners() const { return corners_; }
 
   /// Initialize matrix for linear problem.
   void initMatrix();
@@ -251,20 +393,56 @@ public:
   // corresponding entry in returned array has value -1.
   ArrayXXi const &coordsMap() const { return coordsMap_; }
 
-  /// Mask that has been extended if necessary so that each of the number of
-  /// rows and the number of columns is a power of two.  When first
-  /// initialized, each element is true only if corresponding pixel should be
-  /// filled.  However, after construction is done, an element is true only if
-  /// corresponding pixel both be not involved in any square interpolant and
-  /// should be solved for.
+  /// Mask, of same size as image.  Binning in search for squares needs no
+  /// padding, because each level of binning leaves out odd last row or
+  /// column of level below.  When first initialized, each element is true
+  /// only if corresponding pixel should be filled.  However, after
+  /// construction is done, an element is true only if corresponding pixel
+  /// both be not involved in any square interpolant and should be solved
+  /// for.
   ArrayXX<bool> const &extendedMask() const { return extendedMask_; }
 
-  template<typename C> VectorXf operator()(C *image, int stride= 1);
-
-  /// Square matrix for linear problem.
+  /// Fill pixels of image, which may be window onto larger canvas.
+  /// \tparam C       Type of each component in image.
+  /// \param  image   Pointer to first component of top-left pixel of image.
+  /// \param  stride  Pointer-increments between consecutive pixels.
+  /// \param  pitch   Pointer-increments between consecutive rows, or zero for
+  ///                 `width*stride`.
+  /// \return         Solution to linear system.
+  template<typename C>
+  VectorXf operator()(C *image, int stride= 1, int pitch= 0) const;
+
+  /// Fill pixels of image by way of caller's workspace, so that several
+  /// threads may fill images at once.  Otherwise, same as
+  /// operator()(C*, int, int).
+  /// \tparam C       Type of each component in image.
+  /// \param  image   Pointer to first component of top-left pixel of image.
+  /// \param  ws      Workspace, which holds solution on return.
+  /// \param  stride  Pointer-increments between consecutive pixels.
+  /// \param  pitch   Pointer-increments between consecutive rows, or zero for
+  ///                 `width*stride`.
+  /// \return         Reference to solution in `ws`.
+  template<typename C>
+  VectorXf const &
+  operator()(C *image, Workspace &ws, int stride= 1, int pitch= 0) const;
+
+  /// Symmetric, positive-definite matrix for linear problem.  Each row is
+  /// negated Laplacian at pixel, divided by rowScale() of pixel.
   SparseMatrix<float> const &a() const { return a_; }
 
-  VectorXf const &b() const { return b_; }
+  /// Time spent in each phase, and size of linear problem.  Times are
+  /// recorded only when DIRICHLET_STATS is defined at compile-time.
+  /// \return  Time spent in each phase, and size of linear problem.
+  Stats stats() const {
+    Stats st    = rec_.stats();
+    st.nnzA     = a_.nonZeros();
+    st.nnzFactor= (A_ ? A_->rawMatrix().nonZeros() : 0);
+    return st;
+  }
+
+  /// Write every phase recorded so far as Chrome-trace JSON.
+  /// \param os  Stream to which to write.
+  void trace(std::ostream &os) const { rec_.trace(os); }
 };
 
 
@@ -274,8 +452,7 @@ public:
 // Implementation.
 // ---------------
 
-#include "impl/Image.hpp" // Image, ImageMap
-#include "impl/pow2.hpp"  // pow2()
+#include "impl/Image.hpp" // Image, ImageMap, ImageMapStride
 
 namespace dirichlet {
 
@@ -292,29 +469,23 @@ using std::vector;
 
 
 template<typename P> void FillBiLin::extendMask(P const *msk, int stride) {
-  using impl::pow2;
-  // Allocate space for extended mask.
-  extendedMask_= ArrayXX<bool>::Zero(pow2(h()), pow2(w()));
   // Map mask to logical image.
-  impl::ImageMap<P const> mask(msk, h(), w(), stride);
-  // Initialize range of rows and columns for copying.
-  auto const rseq= seq(0, h() - 1);
-  auto const cseq= seq(0, w() - 1);
-  // Copy original mask into extended mask, and convert to ones and zeros.
-  extendedMask_(rseq, cseq)= (mask != P(0));
+  impl::ImageMapStride const st(w() * stride, stride);
+  impl::ImageMap<P const>    mask(msk, h(), w(), st);
+  // Copy mask, and convert to ones and zeros.
+  extendedMask_= (mask != P(0));
 }
 
 
-void FillBiLin::registerSquare(int r, int c, int bf) {
-  int const top= r * bf;       // Top    unbinned row.
-  int const lft= c * bf;       // Left   unbinned column.
-  int const bot= top + bf - 1; // Bottom unbinned row.
-  int const rgt= lft + bf - 1; // Right  unbinned column.
-  registerSquareWeights(top, lft, bot, rgt);
+void FillBiLin::registerSquare(int top, int lft, int n) {
+  int const bot= top + n - 1; // Bottom unbinned row.
+  int const rgt= lft + n - 1; // Right  unbinned column.
   eliminateSquareFromMask(top, lft, bot, rgt);
   // Add corner and size for current square.
-  corners_.row(nSquares_) << top, lft, bf;
-  // Mark as to be interpolated in coordsMap_.
+  corners_.row(nSquares_) << top, lft, n;
+  // Mark perimeter as to be solved for, and interior as to be interpolated,
+  // in coordsMap_.  Offset of each solved pixel is assigned in initMatrix().
+  coordsMap_(seq(top, bot), seq(lft, rgt))                = 0;
   coordsMap_(seq(top + 1, bot - 1), seq(lft + 1, rgt - 1))= -2;
   // Increment number of squares.
   ++nSquares_;
@@ -324,33 +495,23 @@ void FillBiLin::registerSquare(int r, int c, int bf) {
 void FillBiLin::registerSquareWeights(int top, int lft, int bot, int rgt) {
   // Distance (pixels) from one edge to other.
   // Should be same as `rgt - lft`.
-  int const  s       = bot - top;
-  auto const crnrRows= seq(top, bot, s);
-  auto const crnrCols= seq(lft, rgt, s);
-  auto const edgeRows= seq(top + 1, bot - 1);
-  auto const edgeCols= seq(lft + 1, rgt - 1);
+  int const s = bot - top;
+  int const cw= -3 * s - 1;
+  auto      u = [this](int r, int c) { return coordsMap_(r, c); };
   // Write weights for corners.
-  weights_.top()(crnrRows, crnrCols)= +1;
-  weights_.bot()(crnrRows, crnrCols)= +1;
-  weights_.lft()(crnrRows, crnrCols)= +1;
-  weights_.rgt()(crnrRows, crnrCols)= +1;
-  weights_.cen()(crnrRows, crnrCols)= -4;
+  for(int r: {top, bot}) {
+    for(int c: {lft, rgt}) weights_.set(u(r, c), +1, +1, +1, +1, -4);
+  }
   // Write weights for vertical edges.
-  weights_.top()(edgeRows, crnrCols)= +s;
-  weights_.bot()(edgeRows, crnrCols)= +s;
-  weights_.lft()(edgeRows, lft)     = +s;
-  weights_.lft()(edgeRows, rgt)     = +1;
-  weights_.rgt()(edgeRows, lft)     = +1;
-  weights_.rgt()(edgeRows, rgt)     = +s;
-  weights_.cen()(edgeRows, crnrCols)= -3 * s - 1;
+  for(int r= top + 1; r < bot; ++r) {
+    weights_.set(u(r, lft), +s, +1, +s, +s, cw);
+    weights_.set(u(r, rgt), +1, +s, +s, +s, cw);
+  }
   // Write weights for horizontal edges.
-  weights_.top()(top, edgeCols)     = +s;
-  weights_.top()(bot, edgeCols)     = +1;
-  weights_.bot()(top, edgeCols)     = +1;
-  weights_.bot()(bot, edgeCols)     = +s;
-  weights_.lft()(crnrRows, edgeCols)= +s;
-  weights_.rgt()(crnrRows, edgeCols)= +s;
-  weights_.cen()(crnrRows, edgeCols)= -3 * s - 1;
+  for(int c= lft + 1; c < rgt; ++c) {
+    weights_.set(u(top, c), +s, +s, +s, +1, cw);
+    weights_.set(u(bot, c), +s, +s, +1, +s, cw);
+  }
 }
 
 
@@ -361,73 +522,176 @@ void FillBiLin::eliminateSquareFromMask(int top, int lft, int bot, int rgt) {
 }
 
 
-void FillBiLin::populateCornerWeights(int h, int w) {
-  if(extendedMask_(0, 0)) {
-    weights_.bot()(0, 0)= +1;
-    weights_.rgt()(0, 0)= +1;
-    weights_.cen()(0, 0)= -2;
+float FillBiLin::squareError(int top, int lft, int n) const {
+  if(depth2_.size() == 0) return 0.0f;
+  int const bot= top + n - 1;
+  int const rgt= lft + n - 1;
+  int       d2 = depth2_(top, lft);
+  for(int k= 0; k < n; ++k) {
+    d2= std::min(d2, std::min(depth2_(top, lft + k), depth2_(bot, lft + k)));
+    d2= std::min(d2, std::min(depth2_(top + k, lft), depth2_(top + k, rgt)));
+  }
+  return errorScale * float(n) * float(n) / float(d2);
+}
+
+
+template<typename P> void FillBiLin::binMask(P const *msk, int stride) {
+  int top= 0; // Offset of coarsest level, at largest binning factor.
+  for(int f= maxBinFactor(h(), w()); f > 1; f/= 2) ++top;
+  int const                nr= int(extendedMask_.rows());
+  int const                nc= int(extendedMask_.cols());
+  impl::MaskPyramid const  pyr(msk, h(), w(), stride, nr, nc, top);
+  impl::MaskPyramid::Level taken(pyr[top].rows, pyr[top].cols);
+  // Smallest square is at binning-factor 4.
+  for(int L= top; L >= 2; --L) {
+    registerSquares(pyr.validSquares(L), 1 << L, taken);
+    if(L > 2) taken= pyr.unbin(taken, L);
   }
-  if(extendedMask_(0, w - 1)) {
-    weights_.bot()(0, w - 1)= +1;
-    weights_.lft()(0, w - 1)= +1;
-    weights_.cen()(0, w - 1)= -2;
+}
+
+
+void FillBiLin::placeSquares() {
+  int const  nr  = h();
+  int const  nc  = w();
+  auto const hole= extendedMask_(seq(0, nr - 1), seq(0, nc - 1));
+  if(nr < 3 || nc < 3) return;
+  // Pixel may be in square only if it and its eight neighbors be in hole.
+  auto const    rs= seq(1, nr - 2);
+  auto const    cs= seq(1, nc - 2);
+  ArrayXX<bool> in= hole(rs, cs);
+  for(int dr= -1; dr <= 1; ++dr) {
+    for(int dc= -1; dc <= 1; ++dc) {
+      in= in && hole(seq(1 + dr, nr - 2 + dr), seq(1 + dc, nc - 2 + dc));
+    }
   }
-  if(extendedMask_(h - 1, w - 1)) {
-    weights_.top()(h - 1, w - 1)= +1;
-    weights_.lft()(h - 1, w - 1)= +1;
-    weights_.cen()(h - 1, w - 1)= -2;
+  // Summed area of pixels that may not be in square, so that each candidate
+  // is checked in constant time.
+  ArrayXXi out= ArrayXXi::Zero(nr + 1, nc + 1);
+  for(int c= 0; c < nc; ++c) {
+    for(int r= 0; r < nr; ++r) {
+      bool const ok= (r > 0 && c > 0 && r < nr - 1 && c < nc - 1 &&
+                      in(r - 1, c - 1));
+      out(r + 1, c + 1)= !ok + out(r, c + 1) + out(r + 1, c) - out(r, c);
+    }
   }
-  if(extendedMask_(h - 1, 0)) {
-    weights_.top()(h - 1, 0)= +1;
-    weights_.rgt()(h - 1, 0)= +1;
-    weights_.cen()(h - 1, 0)= -2;
+  auto const fits= [&](int top, int lft, int n) {
+    if(top < 0 || lft < 0 || top + n > nr || lft + n > nc) return false;
+    int const bot= top + n;
+    int const rgt= lft + n;
+    return out(bot, rgt) - out(top, rgt) - out(bot, lft) + out(top, lft) == 0;
+  };
+  // Squares already registered, listed in each cell of coarse grid that they
+  // touch, so that check for overlap examines only nearby squares.
+  int const           g = 64;
+  int const           gc= (nc + g - 1) / g;
+  vector<vector<int>> cells(((nr + g - 1) / g) * gc);
+
+  auto const overlaps= [&](int top, int lft, int n) {
+    for(int cr= top / g; cr <= (top + n - 1) / g; ++cr) {
+      for(int cc= lft / g; cc <= (lft + n - 1) / g; ++cc) {
+        for(int k: cells[cr * gc + cc]) {
+          int const t= corners_(k, 0);
+          int const l= corners_(k, 1);
+          int const m= corners_(k, 2);
+          if(t < top + n && top < t + m && l < lft + n && lft < l + m) {
+            return true;
+          }
+        }
+      }
+    }
+    return false;
+  };
+  // Each round measures distance to boundary and to every square already
+  // registered, and registers only squares at least half as large as first
+  // in round, so that small squares do not crowd out larger ones.
+  vector<int> order;
+  for(int placed= 1; placed > 0;) {
+    placed= 0;
+    // Smallest square, with its neighbors, requires distance of three.
+    ArrayXXi const d2= impl::edt(hole);
+    order.clear();
+    for(int i= 0; i < nr * nc; ++i) {
+      if(d2(i) >= 9) order.push_back(i);
+    }
+    std::stable_sort(order.begin(), order.end(), [&d2](int i, int j) {
+      return d2(i) > d2(j);
+    });
+    int least= 4; // Smallest side registered in round.
+    for(int i: order) {
+      int const r= i % nr;
+      int const c= i / nr;
+      if(!extendedMask_(r, c)) continue; // Already in square.
+      // Square centered at (r,c) cannot extend farther than distance.
+      for(int n= 2 * int(std::sqrt(double(d2(i)))); n >= least; --n) {
+        int const top= r - n / 2;
+        int const lft= c - n / 2;
+        if(!fits(top, lft, n) || overlaps(top, lft, n)) continue;
+        float const e= squareError(top, lft, n);
+        if(e > maxError_) continue;
+        error_= std::max(error_, e);
+        for(int cr= top / g; cr <= (top + n - 1) / g; ++cr) {
+          for(int cc= lft / g; cc <= (lft + n - 1) / g; ++cc) {
+            cells[cr * gc + cc].push_back(nSquares_);
+          }
+        }
+        registerSquare(top, lft, n);
+        if(placed++ == 0) least= std::max(4, n / 2);
+        break;
+      }
+    }
   }
 }
 
 
-void FillBiLin::populateEdgeWeights(int h, int w) {
-  auto const rows            = seq(1, h - 2);
-  auto const cols            = seq(1, w - 2);
-  auto const lftMask         = extendedMask_(rows, 0);
-  auto const topMask         = extendedMask_(0, cols);
-  auto const rgtMask         = extendedMask_(rows, w - 1);
-  auto const botMask         = extendedMask_(h - 1, cols);
-  weights_.top()(rows, 0)    = lftMask.cast<int16_t>() * (+1);
-  weights_.rgt()(rows, 0)    = lftMask.cast<int16_t>() * (+1);
-  weights_.bot()(rows, 0)    = lftMask.cast<int16_t>() * (+1);
-  weights_.cen()(rows, 0)    = lftMask.cast<int16_t>() * (-3);
-  weights_.lft()(0, cols)    = topMask.cast<int16_t>() * (+1);
-  weights_.rgt()(0, cols)    = topMask.cast<int16_t>() * (+1);
-  weights_.bot()(0, cols)    = topMask.cast<int16_t>() * (+1);
-  weights_.cen()(0, cols)    = topMask.cast<int16_t>() * (-3);
-  weights_.top()(rows, w - 1)= rgtMask.cast<int16_t>() * (+1);
-  weights_.lft()(rows, w - 1)= rgtMask.cast<int16_t>() * (+1);
-  weights_.bot()(rows, w - 1)= rgtMask.cast<int16_t>() * (+1);
-  weights_.cen()(rows, w - 1)= rgtMask.cast<int16_t>() * (-3);
-  weights_.lft()(h - 1, cols)= botMask.cast<int16_t>() * (+1);
-  weights_.rgt()(h - 1, cols)= botMask.cast<int16_t>() * (+1);
-  weights_.top()(h - 1, cols)= botMask.cast<int16_t>() * (+1);
-  weights_.cen()(h - 1, cols)= botMask.cast<int16_t>() * (-3);
+void FillBiLin::initWeights() {
+  weights_= impl::Weights(nSolvePix_);
+  for(int i= 0; i < nSolvePix_; ++i) {
+    int const r= coords_(i, 0);
+    int const c= coords_(i, 1);
+    if(!extendedMask_(r, c)) continue; // On perimeter of square.
+    int const l= (c > 0);
+    int const g= (c < w() - 1);
+    int const t= (r > 0);
+    int const b= (r < h() - 1);
+    weights_.set(i, l, g, t, b, -(l + g + t + b));
+  }
+  for(int k= 0; k < nSquares_; ++k) {
+    int const top= corners_(k, 0);
+    int const lft= corners_(k, 1);
+    int const s  = corners_(k, 2) - 1;
+    registerSquareWeights(top, lft, top + s, lft + s);
+  }
 }
 
 
-void FillBiLin::populateInteriorWeights(int h, int w) {
-  auto const rows= seq(1, h - 2);
-  auto const cols= seq(1, w - 2);
-  auto const mask= extendedMask_(rows, cols).cast<int16_t>();
-  weights_.top()(rows, cols)+= mask * (+1);
-  weights_.bot()(rows, cols)+= mask * (+1);
-  weights_.lft()(rows, cols)+= mask * (+1);
-  weights_.rgt()(rows, cols)+= mask * (+1);
-  weights_.cen()(rows, cols)+= mask * (-4);
+void FillBiLin::initGather() {
+  auto const &cm= coordsMap_;
+  gather_.clear();
+  for(int i= 0; i < nSolvePix_; ++i) {
+    int const r= coords_(i, 0);
+    int const c= coords_(i, 1);
+    // Only pixel outside every square can touch boundary.
+    if(!extendedMask_(r, c)) continue;
+    float const norm= 1.0f / rowScale(weights_.cen()(i));
+    float const wt  = weights_.top()(i) * norm;
+    float const wl  = weights_.lft()(i) * norm;
+    float const wb  = weights_.bot()(i) * norm;
+    float const wr  = weights_.rgt()(i) * norm;
+    if(r > 0 && cm(r - 1, c) == -1) gather_.push_back({i, r - 1, c, wt});
+    if(c > 0 && cm(r, c - 1) == -1) gather_.push_back({i, r, c - 1, wl});
+    if(r < h() - 1 && cm(r + 1, c) == -1) gather_.push_back({i, r + 1, c, wb});
+    if(c < w() - 1 && cm(r, c + 1) == -1) gather_.push_back({i, r, c + 1, wr});
+  }
 }
 
 
 void FillBiLin::initMatrix() {
-  coords_= ArrayX2i(h() * w(), 2);
+  auto const start= impl::Recorder::now();
+  coords_         = ArrayX2i(h() * w(), 2);
   for(int c= 0; c < w(); ++c) {
     for(int r= 0; r < h(); ++r) {
-      if(weights_.cen()(r, c) != 0) {
+      // Pixel is solved for if it be in mask or on perimeter of square.
+      if(extendedMask_(r, c) || coordsMap_(r, c) == 0) {
         coords_(nSolvePix_, 0)= r;
         coords_(nSolvePix_, 1)= c;
         ++nSolvePix_;
@@ -439,6 +703,10 @@ void FillBiLin::initMatrix() {
   ArrayXi const lo= /*rows*/ coords_.col(0) + /*cols*/ coords_.col(1) * h();
   // Initialize every pixel to be solved for in coordsMap_.
   coordsMap_.reshaped()(lo)= ArrayXi::LinSpaced(nSolvePix_, 0, nSolvePix_ - 1);
+  initWeights();
+  rec_.add(NEIGHBORS, start, impl::Recorder::now());
+  impl::Scope const s(rec_, ASSEMBLY);
+  initGather();
   vector<Triplet<float>> t;
   // At *most* five coefficients in matrix for each solved-for pixel.
   // - Fewer than five coefficients for each solved-for pixel that touches one
@@ -451,22 +719,24 @@ void FillBiLin::initMatrix() {
   // - Three coefficients for each solved-for pixel at corner of image.
   t.reserve(coords_.rows() * 5);
   for(int i= 0; i < coords_.rows(); ++i) {
-    // FIXME: THIS LOOP NEEDS TO BE ADJUSTED TO HANDLE SIDE OF EACH
-    // INTERPOLABLE SQUARE!  IT IS BROKEN UNTIL THAT IS DONE!
     int const r = coords_(i, 0);
     int const c = coords_(i, 1);
-    int const cw= weights_.cen()(r, c);
-    int const lw= weights_.lft()(r, c);
-    int const rw= weights_.rgt()(r, c);
-    int const tw= weights_.top()(r, c);
-    int const bw= weights_.bot()(r, c);
-    t.push_back({i, i, 1.0f});
+    int const cw= weights_.cen()(i);
+    int const lw= weights_.lft()(i);
+    int const rw= weights_.rgt()(i);
+    int const tw= weights_.top()(i);
+    int const bw= weights_.bot()(i);
+    // Row is negated Laplacian, divided by scale of pixel's weights, so that
+    // matrix is symmetric and positive-definite.
+    float const norm= -1.0f / rowScale(cw);
+    t.push_back({i, i, cw * norm});
     int lOff= coordsMap_(r, c - 1);
     int tOff= coordsMap_(r - 1, c);
     int rOff= coordsMap_(r, c + 1);
     int bOff= coordsMap_(r + 1, c);
     if(cw < -4) {
-      int const s= (-cw - 1) / 3;
+      // Unit-weight refers to pixel on opposite edge of square.
+      int const s= rowScale(cw);
       if(lw == 1) {
         lOff= coordsMap_(r, c - s);
       } else if(rw == 1) {
@@ -479,11 +749,10 @@ void FillBiLin::initMatrix() {
         throw "cw < -4 but no side has unit-value";
       }
     }
-    bool const  lftSolv= (c > 0 && lOff > -1);
-    bool const  topSolv= (r > 0 && tOff > -1);
-    bool const  rgtSolv= (c < w() - 1 && rOff > -1);
-    bool const  botSolv= (r < h() - 1 && bOff > -1);
-    float const norm   = 1.0f / cw;
+    bool const lftSolv= (c > 0 && lOff > -1);
+    bool const topSolv= (r > 0 && tOff > -1);
+    bool const rgtSolv= (c < w() - 1 && rOff > -1);
+    bool const botSolv= (r < h() - 1 && bOff > -1);
     if(lw != 0 && lftSolv) t.push_back({i, lOff, lw * norm});
     if(rw != 0 && rgtSolv) t.push_back({i, rOff, rw * norm});
     if(tw != 0 && topSolv) t.push_back({i, tOff, tw * norm});
@@ -491,62 +760,55 @@ void FillBiLin::initMatrix() {
   }
   a_= SparseMatrix<float>(coords_.rows(), coords_.rows());
   a_.setFromTriplets(t.begin(), t.end());
+  impl::Scope const f(rec_, FACTOR);
   A_= new SimplicialCholesky<SparseMatrix<float>>(a_);
 }
 
 
 // Maximum number of corners is h*w/16 because smallest square has 16 pixels.
 template<typename P>
-FillBiLin::FillBiLin(P const *msk, int w, int h, int stride):
-    weights_(h, w),                   //
+FillBiLin::FillBiLin(
+      P const *msk, int w, int h, int stride, Placement place, float error):
+    h_(h),                            //
+    w_(w),                            //
+    maxError_(error),                 //
     coords_(h * w, 2),                //
     coordsMap_(-ArrayXXi::Ones(h, w)) // By default -1, which means image-val.
 {
-  extendMask(msk, stride);
+  {
+    impl::Scope const s(rec_, SCAN);
+    extendMask(msk, stride);
+  }
+  auto const start= impl::Recorder::now();
   if(extendedMask_.rows() < 2 || extendedMask_.cols() < 2) {
     cerr << "FillBilLin: ERROR: m0 too small" << std::endl;
     return;
   }
-  ArrayXX<bool> const m1= impl::bin2x2(extendedMask_);
-  if(m1.rows() < 2 || m1.cols() < 2) {
-    cerr << "FillBilLin: ERROR: m1 too small" << endl;
-    return;
-  }
   // Smallest square has 16 pixels.
   corners_.resize(h * w / 16, 3);
-  binMask(m1, 4);
+  if(maxError_ < std::numeric_limits<float>::infinity()) {
+    depth2_= impl::edt(extendedMask_(seq(0, h - 1), seq(0, w - 1)));
+  }
+  if(place == DEEPEST) {
+    placeSquares();
+  } else {
+    binMask(msk, stride);
+  }
+  depth2_.resize(0, 0);
   corners_.conservativeResize(nSquares_, 3);
-  populateCornerWeights(h, w);
-  populateEdgeWeights(h, w);
-  populateInteriorWeights(h, w);
+  rec_.add(COORDS, start, impl::Recorder::now());
   initMatrix();
 }
 
 
-template<typename I> VectorXf FillBiLin::solve(I const &im) {
-  int const   R = w() - 1;
-  int const   B = h() - 1;
-  auto const &cm= coordsMap_;
-  auto const &w = weights_;
-  b_            = VectorXf::Zero(nSolvePix_);
-  for(int i= 0; i < coords_.rows(); ++i) {
-    int const r= coords_(i, 0);
-    int const c= coords_(i, 1);
-    if(extendedMask_(r, c)) {
-      // Value at (r,c) is to be solved for.
-      int const   s   = cm(r, c);
-      float const norm= 1.0f / w.cen()(r, c);
-      float const wt  = w.top()(r, c) * norm;
-      float const wl  = w.lft()(r, c) * norm;
-      float const wb  = w.bot()(r, c) * norm;
-      float const wr  = w.rgt()(r, c) * norm;
-      if(r > 0 && cm(r - 1, c) == -1) b_(s)-= wt * im(r - 1, c);
-      if(c > 0 && cm(r, c - 1) == -1) b_(s)-= wl * im(r, c - 1);
-      if(r < B && cm(r + 1, c) == -1) b_(s)-= wb * im(r + 1, c);
-      if(c < R && cm(r, c + 1) == -1) b_(s)-= wr * im(r, c + 1);
-    }
-  }
-  return A_->solve(b_);
+template<typename I>
+void FillBiLin::solve(I const &im, Workspace &ws) const {
+  auto const st= impl::Recorder::now();
+  ws.b.setZero(nSolvePix_);
+  for(Gather const &g: gather_) ws.b(g.unknown)+= g.weight * im(g.row, g.col);
+  rec_.add(GATHER, st, impl::Recorder::now());
+  impl::Scope const s(rec_, SOLVE);
+  ws.x= A_->solve(ws.b);
 }
 
 
@@ -554,12 +816,13 @@ template<typename I>
 void FillBiLin::copySolutionBackIntoImage(I &im, VectorXf const &x) const {
   using C                   = typename I::Scalar;
   constexpr bool is_integral= is_integral_v<C>;
+  impl::Scope const s(rec_, WRITE_BACK);
   // Image is row-major.
   // auto const ii= /*col*/ coords_.col(0) * w() + /*row*/ coords_.col(1);
   auto const ii= coords_.col(0) + h() * coords_.col(1);
   if constexpr(is_integral) {
     if constexpr(is_unsigned_v<C>) {
-      im(ii)= (x.array() + 0.5f).cast<C>();
+      im.reshaped()(ii)= (x.array() + 0.5f).cast<C>();
     } else {
       auto const neg= (x.array() < 0.0f).cast<C>();
       auto const rup= (x.array() + 0.5f).cast<C>();
@@ -577,16 +840,61 @@ void FillBiLin::copySolutionBackIntoImage(I &im, VectorXf const &x) const {
 }
 
 
-template<typename C> VectorXf FillBiLin::operator()(C *image, int stride) {
-  impl::ImageMap<C> im(image, h(), w(), stride);
-  VectorXf const    x          = solve(im);
-  constexpr bool    is_const   = is_const_v<C>;
-  constexpr bool    is_integral= is_integral_v<C>;
-  constexpr bool    is_fp      = is_floating_point_v<C>;
+template<typename I>
+void FillBiLin::fillSquares(I &im, VectorXf const &x) const {
+  using C= typename I::Scalar;
+  impl::Scope const sc(rec_, WRITE_BACK);
+  // Round integer to nearest, with half away from zero, as interpolate().
+  auto const cast= [](float v) {
+    if constexpr(is_integral_v<C>) return C(v < 0.0f ? v - 0.5f : v + 0.5f);
+    else return C(v);
+  };
+  for(int k= 0; k < nSquares_; ++k) {
+    int const top= corners_(k, 0);
+    int const lft= corners_(k, 1);
+    int const s  = corners_(k, 2) - 1; // Distance from corner to corner.
+    int const bot= top + s;
+    int const rgt= lft + s;
+    // Solved value at center of each corner-pixel.
+    float const v00= x(coordsMap_(top, lft));
+    float const v01= x(coordsMap_(top, rgt));
+    float const v10= x(coordsMap_(bot, lft));
+    float const v11= x(coordsMap_(bot, rgt));
+    float const a  = 1.0f / s;
+    // Write interior directly into image, so that no temporary is made.
+    for(int r= 1; r < s; ++r) {
+      float const y= r * a;
+      float const l= v00 + (v10 - v00) * y; // Value on left  edge.
+      float const g= v01 + (v11 - v01) * y; // Value on right edge.
+      float const m= (g - l) * a;
+      for(int c= 1; c < s; ++c) im(top + r, lft + c)= cast(l + m * c);
+    }
+  }
+}
+
+
+template<typename C>
+VectorXf FillBiLin::operator()(C *image, int stride, int pitch) const {
+  Workspace ws;
+  (*this)(image, ws, stride, pitch);
+  return std::move(ws.x);
+}
+
+
+template<typename C>
+VectorXf const &
+FillBiLin::operator()(C *image, Workspace &ws, int stride, int pitch) const {
+  if(pitch == 0) pitch= w() * stride;
+  impl::ImageMap<C> im(image, h(), w(), impl::ImageMapStride(pitch, stride));
+  solve(im, ws);
+  constexpr bool is_const   = is_const_v<C>;
+  constexpr bool is_integral= is_integral_v<C>;
+  constexpr bool is_fp      = is_floating_point_v<C>;
   if constexpr(!is_const && (is_integral || is_fp)) {
-    copySolutionBackIntoImage(im, x);
+    copySolutionBackIntoImage(im, ws.x);
+    fillSquares(im, ws.x);
   }
-  return x;
+  return ws.x;
 }
 
 
@@ -0,0 +1,65 @@
+/// \file       include/dirichlet/Stats.hpp
+/// \copyright  2022 Thomas E. Vaughan.  See terms in LICENSE.
+/// \brief      Definition of dirichlet::Phase and dirichlet::Stats.
+
+#ifndef DIRICHLET_STATS_HPP
+#define DIRICHLET_STATS_HPP
+
+#include <cstdint> // int64_t
+
+namespace dirichlet {
+
+
+/// Phase of construction or of solution, timed separately in Stats.
+enum Phase {
+  SCAN,       ///< Scan of mask for pixels to fill.
+  COORDS,     ///< Check and copy of coordinates, or placement of squares.
+  NEIGHBORS,  ///< Table of neighbors of each filled pixel.
+  ASSEMBLY,   ///< Assembly of matrix or of operator.
+  FACTOR,     ///< Decomposition or preconditioner.
+  GATHER,     ///< Gather of boundary-values into right-hand side.
+  SOLVE,      ///< Solution of linear problem, or relaxation in place.
+  WRITE_BACK, ///< Copy of solution back into image.
+  NUM_PHASES  ///< Number of phases.
+};
+
+
+/// Name of phase, as written in trace.
+/// \param p  Phase.
+/// \return   Name of phase.
+inline char const *phaseName(Phase p) {
+  static char const *const names[]= {"scan",
+                                     "coords",
+                                     "neighbors",
+                                     "assembly",
+                                     "factor",
+                                     "gather",
+                                     "solve",
+                                     "write-back"};
+  return names[p];
+}
+
+
+/// Time spent in each phase, and size of linear problem.
+///
+/// Times, counts of calls, iterations, and residual are recorded only if
+/// `DIRICHLET_STATS` be defined at compile-time; otherwise, they are zero,
+/// and recording them costs nothing.  Sizes are always reported.
+struct Stats {
+  int64_t nanos[NUM_PHASES]= {}; ///< Total wall-time of each phase, in ns.
+  int64_t calls[NUM_PHASES]= {}; ///< Number of times each phase ran.
+  int64_t nnzA             = 0;  ///< Nonzeros in matrix of linear problem.
+  int64_t nnzFactor        = 0;  ///< Nonzeros in every distinct factor.
+  int     iterations       = 0;  ///< Iterations in most recent solution.
+
+  /// Relative residual reported by most recent iterative solution.  For SOR,
+  /// largest change in last sweep relative to largest value.
+  double residual= 0.0;
+};
+
+
+} // namespace dirichlet
+
+#endif // ndef DIRICHLET_STATS_HPP
+
+// EOF
@@ -0,0 +1,239 @@
+/// \file       include/dirichlet/impl/Amg.hpp
+/// \copyright  2022 Thomas E. Vaughan.  See terms in LICENSE.
+/// \brief      Definition of dirichlet::impl::Amg.
+
+#ifndef DIRICHLET_IMPL_AMG_HPP
+#define DIRICHLET_IMPL_AMG_HPP
+
+#include <cmath>               // sqrt
+#include <eigen3/Eigen/Sparse> // SparseMatrix, SimplicialLDLT
+#include <vector>              // vector
+
+namespace dirichlet::impl {
+
+
+using Eigen::ArrayXi;
+using Eigen::ComputationInfo;
+using Eigen::Dynamic;
+using Eigen::Matrix;
+using Eigen::SimplicialLDLT;
+using Eigen::SparseMatrix;
+using Eigen::Success;
+using Eigen::Triplet;
+using std::vector;
+
+
+/// Smoothed-aggregation algebraic-multigrid preconditioner, for use as
+/// third template-parameter of Eigen::ConjugateGradient.
+///
+/// Constructing hierarchy (in compute()) aggregates each node with its
+/// strongly connected neighbors, smooths piecewise-constant tentative
+/// prolongator by one step of damped Jacobi, and forms coarse matrix by
+/// Galerkin-product, until matrix be small enough for direct factorization.
+///
+/// Applying preconditioner (in solve()) is one symmetric V-cycle with damped
+/// Jacobi for pre- and post-smoothing.  So the preconditioner is symmetric
+/// and positive-definite, as conjugate-gradient requires, and number of
+/// iterations stays nearly constant as hole grows.
+///
+/// \tparam S  Type of scalar in matrix.
+template<typename S> class Amg {
+  using Mat= SparseMatrix<S>;             ///< Type of matrix at each level.
+  using Vec= Matrix<S, Dynamic, 1>;       ///< Type of vector.
+  using It = typename Mat::InnerIterator; ///< Iterator over column.
+
+  /// Largest matrix factored directly at coarsest level.
+  static constexpr int coarseSize= 256;
+
+  /// Threshold for strength of connection between nodes.
+  static constexpr S theta= S(0.08);
+
+  /// Number of Jacobi-sweeps before and after coarse-grid correction.
+  static constexpr int nSweeps= 2;
+
+  /// Matrix, prolongator, and smoother for each level but coarsest.
+  struct Level {
+    Mat a;       ///< Matrix at current level.
+    Mat p;       ///< Prolongator from next coarser level.
+    Vec invDiag; ///< Damping factor over diagonal of `a`.
+  };
+
+  vector<Level>       levels_; ///< Every level but coarsest.
+  SimplicialLDLT<Mat> coarse_; ///< Decomposition at coarsest level.
+
+  /// Assign every node of `a` to aggregate.
+  /// \param  a     Symmetric matrix.
+  /// \param  nAgg  On return, number of aggregates.
+  /// \return       Offset of aggregate for each node.
+  static ArrayXi aggregate(Mat const &a, int &nAgg) {
+    int const n   = int(a.cols());
+    Vec const diag= a.diagonal();
+    ArrayXi   agg = ArrayXi::Constant(n, -1);
+    // Strong connection between `i` and `j`.
+    auto const strong= [&](int i, int j, S v) {
+      return i != j && v * v >= theta * theta * diag(i) * diag(j);
+    };
+    nAgg= 0;
+    // First pass: node, all of whose strong neighbors are free, becomes root
+    // of aggregate containing all of them.
+    for(int i= 0; i < n; ++i) {
+      if(agg(i) >= 0) continue;
+      bool free= true;
+      for(It it(a, i); it && free; ++it) {
+        if(strong(i, int(it.index()), it.value())) free= agg(it.index()) < 0;
+      }
+      if(!free) continue;
+      agg(i)= nAgg;
+      for(It it(a, i); it; ++it) {
+        if(strong(i, int(it.index()), it.value())) agg(it.index())= nAgg;
+      }
+      ++nAgg;
+    }
+    // Second pass: free node joins aggregate of strong neighbor from first
+    // pass.
+    ArrayXi const first= agg;
+    for(int i= 0; i < n; ++i) {
+      if(agg(i) >= 0) continue;
+      for(It it(a, i); it; ++it) {
+        int const j= int(it.index());
+        if(strong(i, j, it.value()) && first(j) >= 0) {
+          agg(i)= first(j);
+          break;
+        }
+      }
+    }
+    // Third pass: each remaining node becomes root of aggregate containing
+    // its free strong neighbors.
+    for(int i= 0; i < n; ++i) {
+      if(agg(i) >= 0) continue;
+      agg(i)= nAgg;
+      for(It it(a, i); it; ++it) {
+        int const j= int(it.index());
+        if(strong(i, j, it.value()) && agg(j) < 0) agg(j)= nAgg;
+      }
+      ++nAgg;
+    }
+    return agg;
+  }
+
+  /// Upper bound on spectral radius of `D^-1 a`, where `D` is diagonal of
+  /// `a`, by Gershgorin's theorem.
+  /// \param  a  Symmetric matrix with positive diagonal.
+  /// \return    Upper bound on spectral radius.
+  static S radius(Mat const &a) {
+    S r= 0;
+    for(int j= 0; j < a.outerSize(); ++j) {
+      S sum= 0, d= 0;
+      for(It it(a, j); it; ++it) {
+        sum+= std::abs(it.value());
+        if(it.index() == j) d= it.value();
+      }
+      if(d > 0 && sum / d > r) r= sum / d;
+    }
+    return r;
+  }
+
+  /// Apply `nSweeps` sweeps of damped Jacobi to `x` at level `l`.
+  /// \param l  Offset of level.
+  /// \param b  Right-hand side.
+  /// \param x  Approximate solution to be improved.
+  void smooth(int l, Vec const &b, Vec &x) const {
+    Level const &v= levels_[l];
+    for(int i= 0; i < nSweeps; ++i) {
+      x+= (v.invDiag.array() * (b - v.a * x).array()).matrix();
+    }
+  }
+
+  /// Apply V-cycle at level `l`.
+  /// \param  l  Offset of level.
+  /// \param  b  Right-hand side.
+  /// \return    Approximate solution.
+  Vec cycle(int l, Vec const &b) const {
+    if(l == int(levels_.size())) return coarse_.solve(b);
+    Level const &v= levels_[l];
+    Vec          x= Vec::Zero(b.size());
+    smooth(l, b, x);
+    Vec const r= v.p.transpose() * (b - v.a * x);
+    x+= v.p * cycle(l + 1, r);
+    smooth(l, b, x);
+    return x;
+  }
+
+public:
+  /// Required by Eigen's interface for preconditioner.
+  enum { ColsAtCompileTime= Dynamic, MaxColsAtCompileTime= Dynamic };
+
+  /// Construct empty hierarchy.
+  Amg()= default;
+
+  /// Construct hierarchy for matrix `a`.
+  /// \tparam M  Type of matrix.
+  /// \param  a  Symmetric, positive-definite matrix.
+  template<typename M> explicit Amg(M const &a) { compute(a); }
+
+  /// Nothing to do before values of matrix are known.
+  /// \tparam M  Type of matrix.
+  /// \return    Reference to this preconditioner.
+  template<typename M> Amg &analyzePattern(M const &) { return *this; }
+
+  /// Construct hierarchy for matrix `a`.
+  /// \tparam M   Type of matrix.
+  /// \param  a0  Symmetric, positive-definite matrix.
+  /// \return     Reference to this preconditioner.
+  template<typename M> Amg &factorize(M const &a0) {
+    levels_.clear();
+    Mat a= a0;
+    while(a.rows() > coarseSize) {
+      int           nAgg;
+      ArrayXi const agg= aggregate(a, nAgg);
+      // Stop if aggregation no longer coarsens.
+      if(nAgg * 5 > a.rows() * 4) break;
+      // Tentative prolongator is piecewise constant over aggregates.
+      vector<Triplet<S>> t;
+      t.reserve(a.rows());
+      for(int i= 0; i < a.rows(); ++i) t.push_back({i, agg(i), S(1)});
+      Mat p0(a.rows(), nAgg);
+      p0.setFromTriplets(t.begin(), t.end());
+      // Smooth prolongator by damped Jacobi.
+      S const   w   = S(4) / (S(3) * radius(a));
+      Vec const invD= a.diagonal().cwiseInverse();
+      Mat const dA  = (w * invD).asDiagonal() * a;
+      Level     v;
+      v.p      = p0 - dA * p0;
+      v.invDiag= w * invD;
+      Mat const ac= (v.p.transpose() * a * v.p).pruned();
+      v.a         = std::move(a);
+      levels_.push_back(std::move(v));
+      a= ac;
+    }
+    coarse_.compute(a);
+    return *this;
+  }
+
+  /// Construct hierarchy for matrix `a`.
+  /// \tparam M  Type of matrix.
+  /// \param  a  Symmetric, positive-definite matrix.
+  /// \return    Reference to this preconditioner.
+  template<typename M> Amg &compute(M const &a) { return factorize(a); }
+
+  /// Apply one V-cycle to approximate solution of linear system.
+  /// \tparam B  Type of right-hand side.
+  /// \param  b  Right-hand side.
+  /// \return    Approximate solution.
+  template<typename B> Vec solve(B const &b) const { return cycle(0, b); }
+
+  /// Status of decomposition at coarsest level.
+  /// \return  Status of decomposition at coarsest level.
+  ComputationInfo info() const { return coarse_.info(); }
+
+  /// Number of levels in hierarchy, including coarsest.
+  /// \return  Number of levels in hierarchy.
+  int nLevels() const { return int(levels_.size()) + 1; }
+};
+
+
+} // namespace dirichlet::impl
+
+#endif // ndef DIRICHLET_IMPL_AMG_HPP
+
+// EOF
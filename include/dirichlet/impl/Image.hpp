@@ -4,7 +4,8 @@
 /// \brief      Definition of
 ///               dirichlet::impl::ImageHelper,
 ///               dirichlet::impl::Image,
-///               dirichlet::impl::ImageMap.
+///               dirichlet::impl::ImageMap,
+///               dirichlet::impl::ImageMapStride.
 
 #ifndef DIRICHLET_IMPL_IMAGE_HPP
 #define DIRICHLET_IMPL_IMAGE_HPP
@@ -16,7 +17,6 @@ namespace dirichlet::impl {
 
 using Eigen::Array;
 using Eigen::Dynamic;
-using Eigen::InnerStride;
 using Eigen::RowMajor;
 using Eigen::Unaligned;
 
@@ -50,10 +50,16 @@ template<typename P> struct ImageHelper<P const> {
 template<typename P> using Image= typename ImageHelper<P>::Type;
 
 
+/// Stride of image in memory.  Outer stride is number of pointer-increments
+/// from one row to next (pitch), and inner stride is number from one pixel to
+/// next.  So image may be window onto larger canvas.
+using ImageMapStride= Eigen::Stride<Dynamic, Dynamic>;
+
+
 /// Map used to present image as Image<P>.
 /// \tparam P  Type of each pixel-value in image.
 template<typename P>
-using ImageMap= Eigen::Map<Image<P>, Unaligned, InnerStride<Dynamic>>;
+using ImageMap= Eigen::Map<Image<P>, Unaligned, ImageMapStride>;
 
 
 } // namespace dirichlet::impl
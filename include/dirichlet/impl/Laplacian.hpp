@@ -0,0 +1,245 @@
+/// \file       include/dirichlet/impl/Laplacian.hpp
+/// \copyright  2022 Thomas E. Vaughan.  See terms in LICENSE.
+/// \brief      Definition of dirichlet::impl::Laplacian.
+
+#ifndef DIRICHLET_IMPL_LAPLACIAN_HPP
+#define DIRICHLET_IMPL_LAPLACIAN_HPP
+
+#include "simd.hpp"            // simd, DIRICHLET_X86
+#include <eigen3/Eigen/Sparse> // EigenBase, Product, traits
+#include <type_traits>         // is_same_v
+
+namespace dirichlet::impl {
+template<typename S> class Laplacian;
+} // namespace dirichlet::impl
+
+namespace Eigen::internal {
+
+
+/// Let Eigen treat Laplacian like sparse matrix.
+/// \tparam S  Type of coefficient.
+template<typename S>
+struct traits<dirichlet::impl::Laplacian<S>>:
+    public traits<SparseMatrix<S>> {};
+
+
+} // namespace Eigen::internal
+
+namespace dirichlet::impl {
+
+
+using Eigen::ArrayX4i;
+using Eigen::ArrayXi;
+using Eigen::Dynamic;
+using Eigen::Index;
+
+
+/// Matrix-free operator for five-point Laplacian (four on diagonal, minus one
+/// for each filled neighbor) over filled pixels, for use as matrix-type in
+/// Eigen::ConjugateGradient with Eigen::IdentityPreconditioner.
+///
+/// Only table of neighbors is stored: four indices per filled pixel, with
+/// offset of pixel itself standing in for neighbor in boundary.  Product with
+/// vector reads sixteen bytes of index per row instead of forty or more bytes
+/// of index and value for each row of SparseMatrix, and, when `S` is float,
+/// it is vectorized by gather-instructions of AVX2 or AVX-512, as chosen by
+/// simd() at run time.
+///
+/// \tparam S  Type of coefficient.
+template<typename S= float>
+class Laplacian: public Eigen::EigenBase<Laplacian<S>> {
+  /// Offset of each neighbor (left, right, top, bottom) of each filled pixel,
+  /// or offset of filled pixel itself if neighbor be in boundary.
+  ArrayX4i nbr_;
+
+public:
+  using Scalar      = S;   ///< Type of coefficient.
+  using RealScalar  = S;   ///< Type of real part of coefficient.
+  using StorageIndex= int; ///< Type of index.
+
+  /// Required by Eigen's interface for matrix.
+  enum {
+    ColsAtCompileTime   = Dynamic,
+    MaxColsAtCompileTime= Dynamic,
+    IsRowMajor          = false
+  };
+
+  /// Construct empty operator.
+  Laplacian()= default;
+
+  /// Construct operator from neighbors of each filled pixel.
+  /// \param lrtb  Table of neighbors as returned by Fill::lrtb().
+  explicit Laplacian(ArrayX4i const &lrtb): nbr_(lrtb.rows(), 4) {
+    int const     n   = int(lrtb.rows());
+    ArrayXi const self= ArrayXi::LinSpaced(n, 0, n - 1);
+    for(int d= 0; d < 4; ++d) {
+      auto const b= (lrtb.col(d) < 0).cast<int>();
+      nbr_.col(d) = b * self + (1 - b) * lrtb.col(d);
+    }
+  }
+
+  /// Number of rows.
+  /// \return  Number of rows.
+  Index rows() const { return nbr_.rows(); }
+
+  /// Number of columns.
+  /// \return  Number of columns.
+  Index cols() const { return nbr_.rows(); }
+
+  /// Table of neighbors.
+  /// \return  Table of neighbors.
+  ArrayX4i const &nbr() const { return nbr_; }
+
+  /// Expression for product with vector.
+  /// \tparam R  Type of vector.
+  /// \param  x  Vector.
+  /// \return    Expression for product.
+  template<typename R>
+  Eigen::Product<Laplacian, R, Eigen::AliasFreeProduct>
+  operator*(Eigen::MatrixBase<R> const &x) const {
+    return {*this, x.derived()};
+  }
+
+#ifdef DIRICHLET_X86
+  /// Add `alpha` times product to `y` for rows in blocks of sixteen, by
+  /// AVX-512.
+  /// \param  alpha  Factor.
+  /// \param  x      Pointer to first element of input  vector.
+  /// \param  y      Pointer to first element of output vector.
+  /// \return        Number of rows done.
+  __attribute__((target("avx512f"))) int
+  addProductAvx512(float alpha, float const *x, float *y) const {
+    int const     n  = int(nbr_.rows());
+    __m512 const  va = _mm512_set1_ps(alpha);
+    __m512 const  v4 = _mm512_set1_ps(4.0f);
+    __m512i const v16= _mm512_set1_epi32(16);
+    __m512i       vi = _mm512_setr_epi32(
+          0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14, 15);
+    int i= 0;
+    for(; i + 16 <= n; i+= 16) {
+      __m512 s= _mm512_mul_ps(v4, _mm512_loadu_ps(x + i));
+      for(int d= 0; d < 4; ++d) {
+        __m512i const   j= _mm512_loadu_si512(&nbr_(i, d));
+        __mmask16 const m= _mm512_cmpneq_epi32_mask(j, vi);
+        __m512 const    v= _mm512_mask_i32gather_ps(
+              _mm512_setzero_ps(), m, j, x, sizeof(float));
+        s= _mm512_sub_ps(s, v);
+      }
+      __m512 const y0= _mm512_loadu_ps(y + i);
+      _mm512_storeu_ps(y + i, _mm512_fmadd_ps(va, s, y0));
+      vi= _mm512_add_epi32(vi, v16);
+    }
+    return i;
+  }
+
+  /// Add `alpha` times product to `y` for rows in blocks of eight, by AVX2.
+  /// \param  alpha  Factor.
+  /// \param  x      Pointer to first element of input  vector.
+  /// \param  y      Pointer to first element of output vector.
+  /// \return        Number of rows done.
+  __attribute__((target("avx2"))) int
+  addProductAvx2(float alpha, float const *x, float *y) const {
+    int const     n   = int(nbr_.rows());
+    __m256 const  va  = _mm256_set1_ps(alpha);
+    __m256 const  v4  = _mm256_set1_ps(4.0f);
+    __m256i const v8  = _mm256_set1_epi32(8);
+    __m256i const ones= _mm256_set1_epi32(-1);
+    __m256i       vi  = _mm256_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7);
+    int           i   = 0;
+    for(; i + 8 <= n; i+= 8) {
+      __m256 s= _mm256_mul_ps(v4, _mm256_loadu_ps(x + i));
+      for(int d= 0; d < 4; ++d) {
+        __m256i const j= _mm256_loadu_si256((__m256i const *)&nbr_(i, d));
+        // All ones where neighbor is filled.
+        __m256i const e= _mm256_cmpeq_epi32(j, vi);
+        __m256 const  m= _mm256_castsi256_ps(_mm256_xor_si256(e, ones));
+        __m256 const  v= _mm256_mask_i32gather_ps(
+              _mm256_setzero_ps(), x, j, m, sizeof(float));
+        s= _mm256_sub_ps(s, v);
+      }
+      __m256 const y0= _mm256_loadu_ps(y + i);
+      _mm256_storeu_ps(y + i, _mm256_add_ps(y0, _mm256_mul_ps(va, s)));
+      vi= _mm256_add_epi32(vi, v8);
+    }
+    return i;
+  }
+#endif
+
+  /// Add `alpha` times product of operator with `x` to `y`.
+  /// \param alpha  Factor.
+  /// \param x      Pointer to first element of input  vector.
+  /// \param y      Pointer to first element of output vector.
+  void addProduct(S alpha, S const *x, S *y) const {
+    int const  n= int(nbr_.rows());
+    int const *l= &nbr_(0, 0);
+    int const *r= &nbr_(0, 1);
+    int const *t= &nbr_(0, 2);
+    int const *b= &nbr_(0, 3);
+    int        i= 0;
+#ifdef DIRICHLET_X86
+    if constexpr(std::is_same_v<S, float>) {
+      switch(simd()) {
+      case Simd::AVX512: i= addProductAvx512(alpha, x, y); break;
+      case Simd::AVX2: i= addProductAvx2(alpha, x, y); break;
+      case Simd::SCALAR: break;
+      }
+    }
+#endif
+    for(; i < n; ++i) {
+      S s= 4 * x[i];
+      if(l[i] != i) s-= x[l[i]];
+      if(r[i] != i) s-= x[r[i]];
+      if(t[i] != i) s-= x[t[i]];
+      if(b[i] != i) s-= x[b[i]];
+      y[i]+= alpha * s;
+    }
+  }
+};
+
+
+} // namespace dirichlet::impl
+
+namespace Eigen::internal {
+
+
+/// Implement product of Laplacian with vector for Eigen's expressions.
+/// \tparam S  Type of coefficient of Laplacian.
+/// \tparam R  Type of vector.
+template<typename S, typename R>
+struct generic_product_impl<
+      dirichlet::impl::Laplacian<S>,
+      R,
+      SparseShape,
+      DenseShape,
+      GemvProduct>:
+    generic_product_impl_base<
+          dirichlet::impl::Laplacian<S>,
+          R,
+          generic_product_impl<dirichlet::impl::Laplacian<S>, R>> {
+  /// Type of coefficient.
+  using Scalar= typename Product<dirichlet::impl::Laplacian<S>, R>::Scalar;
+
+  /// Add `alpha` times product of `lhs` and `rhs` to `dst`.
+  /// \tparam D      Type of destination.
+  /// \param  dst    Destination.
+  /// \param  lhs    Operator.
+  /// \param  rhs    Vector.
+  /// \param  alpha  Factor.
+  template<typename D>
+  static void scaleAndAddTo(
+        D                                   &dst,
+        dirichlet::impl::Laplacian<S> const &lhs,
+        R const                             &rhs,
+        Scalar const                        &alpha) {
+    Ref<Matrix<S, Dynamic, 1> const> const x(rhs);
+    Ref<Matrix<S, Dynamic, 1>>             y(dst);
+    lhs.addProduct(alpha, x.data(), y.data());
+  }
+};
+
+
+} // namespace Eigen::internal
+
+#endif // ndef DIRICHLET_IMPL_LAPLACIAN_HPP
+
+// EOF
@@ -0,0 +1,145 @@
+/// \file       include/dirichlet/impl/Ldlt.hpp
+/// \copyright  2022 Thomas E. Vaughan.  See terms in LICENSE.
+/// \brief      Definition of dirichlet::impl::Ldlt.
+
+#ifndef DIRICHLET_IMPL_LDLT_HPP
+#define DIRICHLET_IMPL_LDLT_HPP
+
+#include "ldltSolve.hpp"       // ldltSolve()
+#include <eigen3/Eigen/Sparse> // SimplicialLDLT, SparseMatrix
+#include <memory>              // unique_ptr
+
+namespace dirichlet::impl {
+
+
+using Eigen::ArrayXi;
+using Eigen::Dynamic;
+using Eigen::Matrix;
+using Eigen::RowMajor;
+using Eigen::SimplicialLDLT;
+using Eigen::SparseMatrix;
+using std::unique_ptr;
+
+
+/// Sparse LDLT-decomposition, either computed here or viewed in memory owned
+/// elsewhere (like file mapped into memory).
+///
+/// Either way, decomposition is exposed as raw arrays, which can be written
+/// to file and later viewed without copying.
+///
+/// \tparam S  Type of each coefficient.
+template<typename S= float> class Ldlt {
+  using Vec= Matrix<S, Dynamic, 1>; ///< Type of diagonal.
+
+  /// Decomposition, if computed here.
+  unique_ptr<SimplicialLDLT<SparseMatrix<S>>> own_;
+
+  Vec     ownD_; ///< Diagonal, if computed here.
+  ArrayXi ownP_; ///< Permutation, if computed here.
+
+  int        n_    = 0;       ///< Number of rows and columns.
+  int        nnz_  = 0;       ///< Number of nonzeros in factor.
+  int const *outer_= nullptr; ///< Offset of first nonzero in each column.
+  int const *inner_= nullptr; ///< Row of each nonzero.
+  S const   *value_= nullptr; ///< Value of each nonzero.
+  S const   *diag_ = nullptr; ///< Diagonal.
+  int const *perm_ = nullptr; ///< Indices of permutation.
+
+public:
+  using Scalar= S; ///< Type of each coefficient.
+
+  /// Type of workspace for solve().
+  using Rows= Matrix<S, Dynamic, Dynamic, RowMajor>;
+
+  /// Decompose matrix.
+  /// \param a  Symmetric, positive-definite matrix.
+  explicit Ldlt(SparseMatrix<S> const &a):
+      own_(new SimplicialLDLT<SparseMatrix<S>>(a)),
+      ownD_(own_->vectorD()),
+      ownP_(own_->permutationP().indices()) {
+    // Simplicial factor is always in compressed form.
+    auto const &l= own_->matrixL().nestedExpression();
+    n_           = int(l.cols());
+    nnz_         = int(l.nonZeros());
+    outer_       = l.outerIndexPtr();
+    inner_       = l.innerIndexPtr();
+    value_       = l.valuePtr();
+    diag_        = ownD_.data();
+    perm_        = ownP_.size() ? ownP_.data() : nullptr;
+  }
+
+  /// View decomposition in memory owned elsewhere.
+  /// \param n      Number of rows and columns.
+  /// \param nnz    Number of nonzeros in factor.
+  /// \param outer  Offset of first nonzero in each column, and `nnz` at end.
+  /// \param inner  Row of each nonzero.
+  /// \param value  Value of each nonzero.
+  /// \param diag   Diagonal.
+  /// \param perm   Indices of permutation, or null pointer if none.
+  Ldlt(int        n,
+       int        nnz,
+       int const *outer,
+       int const *inner,
+       S const   *value,
+       S const   *diag,
+       int const *perm):
+      n_(n),
+      nnz_(nnz),
+      outer_(outer),
+      inner_(inner),
+      value_(value),
+      diag_(diag),
+      perm_(perm) {}
+
+  /// Number of rows and columns.
+  /// \return  Number of rows and columns.
+  int rows() const { return n_; }
+
+  /// Number of nonzeros in factor.
+  /// \return  Number of nonzeros in factor.
+  int nonZeros() const { return nnz_; }
+
+  /// Column-major, unit-lower factor.
+  /// \return  View of factor.
+  auto l() const {
+    return Eigen::Map<SparseMatrix<S> const>(
+          n_, n_, nnz_, outer_, inner_, value_);
+  }
+
+  /// Diagonal.
+  /// \return  View of diagonal.
+  auto d() const { return Eigen::Map<Vec const>(diag_, n_); }
+
+  /// Indices of permutation, or empty array if there be no permutation.
+  /// \return  View of indices of permutation.
+  auto p() const {
+    return Eigen::Map<ArrayXi const>(perm_, perm_ ? n_ : 0);
+  }
+
+  /// Solve for every column of `b`.
+  /// \tparam B  Type of matrix of right-hand sides.
+  /// \param  b  Right-hand sides, one per column.
+  /// \return    Solutions, one per column.
+  template<typename B> auto solve(B const &b) const {
+    return ldltSolve(*this, b);
+  }
+
+  /// Solve for every column of `b` into `x` by way of workspace `y`, neither
+  /// of which is reallocated if it already be of right shape.
+  /// \tparam B  Type of matrix of right-hand sides.
+  /// \tparam X  Type of matrix of solutions.
+  /// \param  b  Right-hand sides, one per column.
+  /// \param  x  Solutions, one per column, on return.
+  /// \param  y  Workspace.
+  template<typename B, typename X>
+  void solve(B const &b, X &x, Rows &y) const {
+    ldltSolve(*this, b, x, y);
+  }
+};
+
+
+} // namespace dirichlet::impl
+
+#endif // ndef DIRICHLET_IMPL_LDLT_HPP
+
+// EOF
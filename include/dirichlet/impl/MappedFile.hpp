@@ -0,0 +1,61 @@
+/// \file       include/dirichlet/impl/MappedFile.hpp
+/// \copyright  2022 Thomas E. Vaughan.  See terms in LICENSE.
+/// \brief      Definition of dirichlet::impl::MappedFile.
+
+#ifndef DIRICHLET_IMPL_MAPPED_FILE_HPP
+#define DIRICHLET_IMPL_MAPPED_FILE_HPP
+
+#include <cstddef>    // size_t
+#include <fcntl.h>    // open
+#include <string>     // string
+#include <sys/mman.h> // mmap, munmap
+#include <sys/stat.h> // fstat
+#include <unistd.h>   // close
+
+namespace dirichlet::impl {
+
+
+/// Read-only, POSIX memory-mapping of whole file.  Pages are read from disk
+/// only when first touched.
+class MappedFile {
+  void       *data_= nullptr; ///< Address of first byte.
+  std::size_t size_= 0;       ///< Number of bytes.
+
+public:
+  /// Map file into memory.  Throw exception if file cannot be mapped.
+  /// \param path  Path of file.
+  explicit MappedFile(std::string const &path) {
+    int const fd= ::open(path.c_str(), O_RDONLY);
+    if(fd < 0) throw "MappedFile: cannot open";
+    struct stat st;
+    if(::fstat(fd, &st) != 0 || st.st_size == 0) {
+      ::close(fd);
+      throw "MappedFile: cannot stat";
+    }
+    size_= std::size_t(st.st_size);
+    data_= ::mmap(nullptr, size_, PROT_READ, MAP_PRIVATE, fd, 0);
+    ::close(fd); // Mapping stays valid.
+    if(data_ == MAP_FAILED) throw "MappedFile: cannot map";
+  }
+
+  /// Unmap file.
+  ~MappedFile() { ::munmap(data_, size_); }
+
+  MappedFile(MappedFile const &)= delete;
+  MappedFile &operator=(MappedFile const &)= delete;
+
+  /// Address of first byte.
+  /// \return  Address of first byte.
+  char const *data() const { return static_cast<char const *>(data_); }
+
+  /// Number of bytes.
+  /// \return  Number of bytes.
+  std::size_t size() const { return size_; }
+};
+
+
+} // namespace dirichlet::impl
+
+#endif // ndef DIRICHLET_IMPL_MAPPED_FILE_HPP
+
+// EOF
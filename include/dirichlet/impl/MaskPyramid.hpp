@@ -0,0 +1,238 @@
+/// \file       include/dirichlet/impl/MaskPyramid.hpp
+/// \copyright  2022 Thomas E. Vaughan.  See terms in LICENSE.
+/// \brief      Definition of dirichlet::impl::MaskPyramid.
+
+#ifndef DIRICHLET_IMPL_MASK_PYRAMID_HPP
+#define DIRICHLET_IMPL_MASK_PYRAMID_HPP
+
+#include <cstdint>     // uint8_t, uint64_t
+#include <cstring>     // memcpy
+#include <type_traits> // is_same_v
+#include <vector>      // vector
+
+namespace dirichlet::impl {
+
+
+/// Pyramid of bit-packed masks.  Level zero is mask itself, and each higher
+/// level is logical 2x2 binning of level below, in which pixel is set only if
+/// every pixel in corresponding 2x2 block be set.  Each higher level has half
+/// (rounded down) rows and columns of level below, so that odd last row or
+/// column, which belongs to no whole 2x2 block, is left out, and mask need
+/// not be padded to multiple of any power of two.
+///
+/// Each row of each level is packed into 64-bit words, and every level is
+/// built, word by word, in single pass over rows of row-major mask, so that
+/// mask is read once, in order of memory, and memory for whole pyramid is
+/// less than one third of bit per pixel more than level zero.
+class MaskPyramid {
+public:
+  using Word= uint64_t; ///< Type of word in which pixels are packed.
+
+  /// One level of pyramid.  Pixel at row `r` and column `c` is set if bit
+  /// `c % 64` (counting from least significant) of word `c / 64` in row be
+  /// set.  Bits beyond last column in each row are zero.
+  struct Level {
+    int               rows = 0; ///< Number of rows.
+    int               cols = 0; ///< Number of columns.
+    int               pitch= 0; ///< Number of words in each row.
+    std::vector<Word> bits;     ///< Words of every row, row after row.
+
+    /// Initialize every pixel to zero.
+    /// \param nr  Number of rows.
+    /// \param nc  Number of columns.
+    Level(int nr= 0, int nc= 0):
+        rows(nr), cols(nc), pitch((nc + 63) / 64), bits(nr * pitch, 0) {}
+
+    /// Pointer to first word of row.
+    /// \param r  Offset of row.
+    /// \return   Pointer to first word of row.
+    Word *row(int r) { return bits.data() + r * pitch; }
+
+    /// Pointer to first word of row.
+    /// \param r  Offset of row.
+    /// \return   Pointer to first word of row.
+    Word const *row(int r) const { return bits.data() + r * pitch; }
+
+    /// Value of pixel.
+    /// \param r  Offset of row.
+    /// \param c  Offset of column.
+    /// \return   True if pixel be set.
+    bool operator()(int r, int c) const {
+      return (row(r)[c / 64] >> (c % 64)) & 1;
+    }
+  };
+
+private:
+  std::vector<Level> levels_; ///< Levels, from mask itself upward.
+
+  /// Gather even bits of word into low half.
+  /// \param x  Word.
+  /// \return   Bit `2*i` of `x` at bit `i`.
+  static Word compact(Word x) {
+    x&= 0x5555555555555555;
+    x= (x | (x >> 1)) & 0x3333333333333333;
+    x= (x | (x >> 2)) & 0x0F0F0F0F0F0F0F0F;
+    x= (x | (x >> 4)) & 0x00FF00FF00FF00FF;
+    x= (x | (x >> 8)) & 0x0000FFFF0000FFFF;
+    x= (x | (x >> 16)) & 0x00000000FFFFFFFF;
+    return x;
+  }
+
+  /// Copy each bit in low half of word into two adjacent bits.
+  /// \param x  Word, of which only low half is used.
+  /// \return   Bit `i` of `x` at bits `2*i` and `2*i+1`.
+  static Word spread(Word x) {
+    x&= 0x00000000FFFFFFFF;
+    x= (x | (x << 16)) & 0x0000FFFF0000FFFF;
+    x= (x | (x << 8)) & 0x00FF00FF00FF00FF;
+    x= (x | (x << 4)) & 0x0F0F0F0F0F0F0F0F;
+    x= (x | (x << 2)) & 0x3333333333333333;
+    x= (x | (x << 1)) & 0x5555555555555555;
+    return x | (x << 1);
+  }
+
+  /// Bin two rows of one level into one row of level above.
+  /// \param lo   Level below.
+  /// \param r    Offset of row in level above.
+  /// \param hi   Level above.
+  static void bin(Level const &lo, int r, Level &hi) {
+    Word const *a= lo.row(2 * r);
+    Word const *b= lo.row(2 * r + 1);
+    Word       *o= hi.row(r);
+    for(int k= 0; k < hi.pitch; ++k) {
+      // Both rows, and then both columns of each pair.
+      Word const v0= a[2 * k] & b[2 * k];
+      Word const v1= (2 * k + 1 < lo.pitch ? a[2 * k + 1] & b[2 * k + 1] : 0);
+      o[k]         = compact(v0 & (v0 >> 1)) | compact(v1 & (v1 >> 1)) << 32;
+    }
+  }
+
+  /// Pack eight bytes into eight bits, one for each non-zero byte.
+  /// \param p  Pointer to first byte.
+  /// \return   Bit `i` set if byte `p[i]` be non-zero.
+  static Word pack8(uint8_t const *p) {
+    Word x;
+    std::memcpy(&x, p, 8);
+    // High bit of each byte is set if byte be non-zero.
+    Word const lo7= 0x7F7F7F7F7F7F7F7F;
+    x= (((x & lo7) + lo7) | x) & ~lo7;
+    // Gather high bits into top byte.
+    return (x >> 7) * 0x0102040810204080 >> 56;
+  }
+
+  /// Pack row of mask into words.
+  /// \tparam P       Type of each pixel-value in mask.
+  /// \param  row     Pointer to first pixel of row.
+  /// \param  w       Number of pixels in row.
+  /// \param  stride  Pointer-increments between consecutive pixels.
+  /// \param  o       Pointer to first word of packed row.
+  template<typename P>
+  static void pack(P const *row, int w, int stride, Word *o) {
+    for(int c0= 0; c0 < w; c0+= 64) {
+      int const n  = (w - c0 < 64 ? w - c0 : 64);
+      Word      acc= 0;
+      int       b  = 0;
+      if constexpr(std::is_same_v<P, uint8_t>) {
+        if(stride == 1) {
+          for(; b + 8 <= n; b+= 8) acc|= pack8(row + c0 + b) << b;
+        }
+      }
+      for(; b < n; ++b) acc|= Word(row[(c0 + b) * stride] != P(0)) << b;
+      o[c0 / 64]= acc; // One store for sixty-four pixels.
+    }
+  }
+
+public:
+  /// Empty pyramid.
+  MaskPyramid()= default;
+
+  /// Build every level from row-major mask.
+  ///
+  /// \tparam P       Type of each pixel-value in mask.
+  /// \param  msk     Pointer to first pixel of row-major mask-image.
+  /// \param  h       Number of rows in mask.
+  /// \param  w       Number of columns in mask.
+  /// \param  stride  Pointer-increments between consecutive pixels.
+  /// \param  nr      Number of rows in level zero, at least `h`.  Mask is
+  ///                 extended with zeros.
+  /// \param  nc      Number of columns in level zero, at least `w`.
+  /// \param  top     Offset of highest level.
+  ///
+  template<typename P>
+  MaskPyramid(
+        P const *msk, int h, int w, int stride, int nr, int nc, int top) {
+    if(nr < h || nc < w) throw "size smaller than mask";
+    levels_.reserve(top + 1);
+    for(int L= 0; L <= top; ++L) levels_.emplace_back(nr >> L, nc >> L);
+    for(int r= 0; r < nr; ++r) {
+      if(r < h) pack(msk + r * w * stride, w, stride, levels_[0].row(r));
+      // Bin into each level above as soon as its two rows are ready.  Odd
+      // last row of level is never paired, and so never binned.
+      for(int L= 0, rr= r; L < top && rr % 2 == 1; ++L, rr/= 2) {
+        bin(levels_[L], rr / 2, levels_[L + 1]);
+      }
+    }
+  }
+
+  /// Offset of highest level.
+  /// \return  Offset of highest level.
+  int top() const { return int(levels_.size()) - 1; }
+
+  /// Level of pyramid.
+  /// \param L  Offset of level, zero for mask itself.
+  /// \return   Level.
+  Level const &operator[](int L) const { return levels_[L]; }
+
+  /// Look for valid squares in level.  Pixel is valid only if it and each of
+  /// its four neighbors be set, as in validSquare(), but each row is tested a
+  /// word at a time.
+  /// \param L  Offset of level.
+  /// \return   Valid pixels, in same layout as level.
+  Level validSquares(int L) const {
+    Level const &a= levels_[L];
+    Level        v(a.rows, a.cols);
+    for(int r= 0; r < a.rows; ++r) {
+      Word const *up = (r > 0 ? a.row(r - 1) : nullptr);
+      Word const *cen= a.row(r);
+      Word const *dn = (r < a.rows - 1 ? a.row(r + 1) : nullptr);
+      Word       *o  = v.row(r);
+      for(int k= 0; k < a.pitch; ++k) {
+        Word const prev= (k > 0 ? cen[k - 1] : 0);
+        Word const next= (k < a.pitch - 1 ? cen[k + 1] : 0);
+        Word const lft = (cen[k] << 1) | (prev >> 63);
+        Word const rgt = (cen[k] >> 1) | (next << 63);
+        o[k]= cen[k] & lft & rgt & (up ? up[k] : 0) & (dn ? dn[k] : 0);
+      }
+    }
+    return v;
+  }
+
+  /// Logical 2x2 unbinning of pixels from level onto level below, as in
+  /// unbin2x2().
+  /// \param a  Pixels in layout of level `L`.
+  /// \param L  Offset of level, greater than zero.
+  /// \return   Pixels in layout of level `L-1`.
+  Level unbin(Level const &a, int L) const {
+    Level const &lo= levels_[L - 1];
+    Level        u(lo.rows, lo.cols);
+    for(int r= 0; r < a.rows; ++r) {
+      Word const *i = a.row(r);
+      Word       *o0= u.row(2 * r);
+      Word       *o1= u.row(2 * r + 1);
+      for(int k= 0; k < a.pitch; ++k) {
+        o0[2 * k]= o1[2 * k]= spread(i[k]);
+        if(2 * k + 1 < u.pitch) {
+          o0[2 * k + 1]= o1[2 * k + 1]= spread(i[k] >> 32);
+        }
+      }
+    }
+    return u;
+  }
+};
+
+
+} // namespace dirichlet::impl
+
+#endif // ndef DIRICHLET_IMPL_MASK_PYRAMID_HPP
+
+// EOF
@@ -0,0 +1,174 @@
+/// \file       include/dirichlet/impl/Recorder.hpp
+/// \copyright  2022 Thomas E. Vaughan.  See terms in LICENSE.
+/// \brief      Definition of dirichlet::impl::Recorder.
+
+#ifndef DIRICHLET_IMPL_RECORDER_HPP
+#define DIRICHLET_IMPL_RECORDER_HPP
+
+#include "../Stats.hpp" // Phase, Stats, phaseName()
+#include <ostream>      // ostream
+
+#ifdef DIRICHLET_STATS
+#include "ThreadPool.hpp" // ThreadPool
+#include <atomic>         // atomic
+#include <chrono>         // steady_clock, duration_cast
+#include <cstddef>        // size_t
+#include <mutex>          // mutex, lock_guard
+#include <vector>         // vector
+#endif
+
+namespace dirichlet::impl {
+
+
+#ifdef DIRICHLET_STATS
+
+/// Record of time spent in each phase by one instance of Fill or FillBiLin.
+///
+/// Phases of solution may run in several threads at once, as under
+/// Fill::batch(), so totals are atomic, and each phase is also kept, up to
+/// limit, as event for trace.
+class Recorder {
+public:
+  using Clock= std::chrono::steady_clock; ///< Type of clock.
+  using Stamp= Clock::time_point;         ///< Type of time-stamp.
+
+private:
+  /// One timed phase, for trace.
+  struct Event {
+    Phase    phase; ///< Phase.
+    int64_t  begin; ///< Beginning, in ns since epoch of clock.
+    int64_t  dur;   ///< Duration, in ns.
+    unsigned tid;   ///< Slot of thread in ThreadPool.
+  };
+
+  /// Largest number of events kept for trace.  Later events are counted in
+  /// totals but not traced.
+  static constexpr std::size_t maxEvents= std::size_t(1) << 16;
+
+  std::atomic<int64_t> nanos_[NUM_PHASES]= {}; ///< Time of each phase.
+  std::atomic<int64_t> calls_[NUM_PHASES]= {}; ///< Calls of each phase.
+  std::atomic<int>     iterations_{0};         ///< Most recent iterations.
+  std::atomic<double>  residual_{0.0};         ///< Most recent residual.
+  mutable std::mutex   mutex_;                 ///< Protect events_.
+  std::vector<Event>   events_;                ///< Events for trace.
+
+  /// Nanoseconds since epoch of clock.
+  /// \param t  Time-stamp.
+  /// \return   Nanoseconds since epoch of clock.
+  static int64_t ns(Stamp t) {
+    using std::chrono::duration_cast;
+    using std::chrono::nanoseconds;
+    return duration_cast<nanoseconds>(t.time_since_epoch()).count();
+  }
+
+public:
+  /// Time-stamp for now.
+  /// \return  Time-stamp for now.
+  static Stamp now() { return Clock::now(); }
+
+  /// Record phase that ran from one time-stamp to another.
+  /// \param p  Phase.
+  /// \param b  Time-stamp at beginning.
+  /// \param e  Time-stamp at end.
+  void add(Phase p, Stamp b, Stamp e) {
+    int64_t const begin= ns(b);
+    int64_t const dur  = ns(e) - begin;
+    nanos_[p]+= dur;
+    ++calls_[p];
+    std::lock_guard<std::mutex> lock(mutex_);
+    if(events_.size() < maxEvents) {
+      events_.push_back({p, begin, dur, ThreadPool::slot()});
+    }
+  }
+
+  /// Record convergence of iterative solution.
+  /// \param iterations  Number of iterations.
+  /// \param residual    Relative residual.
+  void converged(int iterations, double residual) {
+    iterations_= iterations;
+    residual_  = residual;
+  }
+
+  /// Totals so far.  Sizes of linear problem are left to caller.
+  /// \return  Totals so far.
+  Stats stats() const {
+    Stats s;
+    for(int p= 0; p < NUM_PHASES; ++p) {
+      s.nanos[p]= nanos_[p];
+      s.calls[p]= calls_[p];
+    }
+    s.iterations= iterations_;
+    s.residual  = residual_;
+    return s;
+  }
+
+  /// Write every event as Chrome-trace JSON, which chrome://tracing and
+  /// Perfetto display.  Time-stamps are from same clock for every instance,
+  /// so that traces of several instances may be merged.
+  /// \param os  Stream to which to write.
+  void trace(std::ostream &os) const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    os << "{\"traceEvents\":[";
+    for(std::size_t i= 0; i < events_.size(); ++i) {
+      Event const &e= events_[i];
+      os << (i ? ",\n" : "\n") << "{\"name\":\"" << phaseName(e.phase)
+         << "\",\"cat\":\"dirichlet\",\"ph\":\"X\",\"pid\":0,\"tid\":" << e.tid
+         << ",\"ts\":" << e.begin / 1000 << '.' << (e.begin % 1000) / 100
+         << ",\"dur\":" << e.dur / 1000 << '.' << (e.dur % 1000) / 100 << '}';
+    }
+    os << "\n]}\n";
+  }
+};
+
+#else // ndef DIRICHLET_STATS
+
+/// Stand-in that records nothing, so that every call compiles away.
+class Recorder {
+public:
+  struct Stamp {}; ///< Empty time-stamp.
+
+  /// Empty time-stamp.
+  /// \return  Empty time-stamp.
+  static Stamp now() { return {}; }
+
+  /// Do nothing.
+  void add(Phase, Stamp, Stamp) {}
+
+  /// Do nothing.
+  void converged(int, double) {}
+
+  /// Zero totals.
+  /// \return  Zero totals.
+  Stats stats() const { return {}; }
+
+  /// Write empty trace.
+  /// \param os  Stream to which to write.
+  void trace(std::ostream &os) const { os << "{\"traceEvents\":[]}\n"; }
+};
+
+#endif // ndef DIRICHLET_STATS
+
+
+/// Record phase from construction to destruction.
+class Scope {
+  Recorder             &rec_;   ///< Recorder.
+  Phase                 phase_; ///< Phase.
+  Recorder::Stamp const begin_; ///< Time-stamp at construction.
+
+public:
+  /// Start timing phase.
+  /// \param rec    Recorder.
+  /// \param phase  Phase.
+  Scope(Recorder &rec, Phase phase):
+      rec_(rec), phase_(phase), begin_(Recorder::now()) {}
+
+  /// Record phase.
+  ~Scope() { rec_.add(phase_, begin_, Recorder::now()); }
+};
+
+
+} // namespace dirichlet::impl
+
+#endif // ndef DIRICHLET_IMPL_RECORDER_HPP
+
+// EOF
@@ -0,0 +1,371 @@
+/// \file       include/dirichlet/impl/Schur.hpp
+/// \copyright  2022 Thomas E. Vaughan.  See terms in LICENSE.
+/// \brief      Definition of dirichlet::impl::Schur.
+
+#ifndef DIRICHLET_IMPL_SCHUR_HPP
+#define DIRICHLET_IMPL_SCHUR_HPP
+
+#include "Ldlt.hpp"            // Ldlt
+#include "ThreadPool.hpp"      // ThreadPool
+#include <algorithm>           // min
+#include <cstdint>             // int64_t
+#include <eigen3/Eigen/Sparse> // SparseMatrix
+#include <memory>              // unique_ptr, make_unique
+#include <unordered_map>       // unordered_map
+#include <vector>              // vector
+
+namespace dirichlet::impl {
+
+
+using Eigen::ArrayX2i;
+using Eigen::ArrayX4i;
+using Eigen::ArrayXi;
+using Eigen::Dynamic;
+using Eigen::Matrix;
+using Eigen::SparseMatrix;
+using Eigen::Triplet;
+using std::make_unique;
+using std::unique_ptr;
+using std::vector;
+
+
+/// Solve five-point Laplacian over filled pixels by nested dissection.
+///
+/// At first level, every row and every column of image whose offset is
+/// multiple of block-size is separator.  Separators cut filled pixels into
+/// square subdomains, whose interiors do not touch one another.  So interior
+/// of each subdomain is decomposed, and its contribution to Schur-complement
+/// on separator is formed, independently and in parallel.
+///
+/// Schur-complement on separator is then dissected in same way, with twice
+/// block-size: pixels of separator that are not on row or column at multiple
+/// of new block-size form interiors of bigger squares, each coupled only to
+/// pixels on edge of its own square.  Block-size doubles from level to level
+/// until separator is empty.  So every level is decomposed in parallel, no
+/// decomposition is larger than that of interior of one square, and only
+/// dense blocks are those that couple edge of each square to itself.
+///
+/// To solve, interiors are eliminated level by level upward, and then they
+/// are back-solved level by level downward.
+///
+/// \tparam S  Type of coefficient.
+template<typename S= float> class Schur {
+  using Mat = Matrix<S, Dynamic, Dynamic>; ///< Type of dense workspace.
+  using Rows= typename Ldlt<S>::Rows;      ///< Type of Ldlt's workspace.
+
+  /// Interior of one square at one level.
+  struct Sub {
+    ArrayXi             rows; ///< Offset in level of each interior unknown.
+    ArrayXi             sep;  ///< Offset in separator of each neighbor.
+    SparseMatrix<S>     c;    ///< Coupling from separator to interior.
+    unique_ptr<Ldlt<S>> a;    ///< Decomposition of interior.
+  };
+
+  /// One level of dissection.  Separator of each level is set of unknowns of
+  /// next level.
+  struct Level {
+    int         n= 0; ///< Number of unknowns in level.
+    vector<Sub> subs; ///< Interior of each square.
+    ArrayXi     sep;  ///< Offset in level of each unknown in separator.
+  };
+
+  /// Scratch for one square.
+  struct SubWork {
+    Mat  r; ///< Right-hand side of interior.
+    Mat  y; ///< Solution of interior.
+    Mat  u; ///< Values on separator-neighbors of interior.
+    Rows t; ///< Workspace of decomposition.
+  };
+
+  /// Number of columns of coupling solved at once while forming
+  /// Schur-complement.  Limits size of dense workspace.
+  static constexpr int chunk= 64;
+
+  int           n_= 0;   ///< Number of unknowns in whole system.
+  vector<Level> levels_; ///< Every level, from first upward.
+
+  /// View of indices, so that indexed expression does not copy them.
+  /// \param a  Indices.
+  /// \return   View of indices.
+  static auto view(ArrayXi const &a) {
+    return Eigen::Map<ArrayXi const>(a.data(), a.size());
+  }
+
+  /// Eliminate interior of each square from matrix, and append level.
+  ///
+  /// \param m   Symmetric matrix over unknowns of level.
+  /// \param xy  Coordinates of each unknown; on return, those of each unknown
+  ///            in separator.
+  /// \param b   Block-size, or zero if every unknown be interior of one
+  ///            square.
+  /// \return    Schur-complement on separator.
+  SparseMatrix<S>
+  dissect(SparseMatrix<S> const &m, ArrayX2i &xy, int64_t b) {
+    using It= typename SparseMatrix<S>::InnerIterator;
+    int const n= int(m.rows());
+    // Assign each unknown either to separator or to square.
+    ArrayXi                          part(n);  // -1 for separator.
+    ArrayXi                          local(n); // Offset within part.
+    std::unordered_map<int64_t, int> subOf;
+    vector<int>                      sep;
+    vector<vector<int>>              rows;
+    for(int i= 0; i < n; ++i) {
+      int64_t const r= xy(i, 0);
+      int64_t const c= xy(i, 1);
+      if(b && (r % b == 0 || c % b == 0)) {
+        part(i) = -1;
+        local(i)= int(sep.size());
+        sep.push_back(i);
+        continue;
+      }
+      int64_t const key= (b ? (r / b) << 32 | (c / b) : 0);
+      auto const    s  = subOf.emplace(key, int(rows.size())).first->second;
+      if(s == int(rows.size())) rows.emplace_back();
+      part(i) = s;
+      local(i)= int(rows[s].size());
+      rows[s].push_back(i);
+    }
+    // Nothing to eliminate if every unknown be on separator.
+    if(rows.empty()) return m;
+    Level     lv;
+    int const ms= int(sep.size());
+    lv.n        = n;
+    lv.sep      = Eigen::Map<ArrayXi const>(sep.data(), ms);
+    lv.subs.resize(rows.size());
+    // Decompose each interior, and form its contribution to Schur-complement.
+    vector<vector<Triplet<S>>> contrib(lv.subs.size());
+    ThreadPool::global().run(int(lv.subs.size()), [&](int s) {
+      Sub      &sub= lv.subs[s];
+      int const ni = int(rows[s].size());
+      sub.rows     = Eigen::Map<ArrayXi const>(rows[s].data(), ni);
+      // Offset, within sub.sep, of each separator-neighbor.
+      std::unordered_map<int, int> adj;
+      vector<Triplet<S>>           ta;
+      vector<Triplet<S>>           tc;
+      for(int k= 0; k < ni; ++k) {
+        for(It it(m, sub.rows(k)); it; ++it) {
+          int const j= int(it.row());
+          if(part(j) == s) {
+            ta.push_back({local(j), k, it.value()});
+          } else {
+            auto const q= adj.emplace(local(j), int(adj.size())).first;
+            tc.push_back({k, q->second, it.value()});
+          }
+        }
+      }
+      int const na= int(adj.size());
+      sub.sep.resize(na);
+      for(auto const &q: adj) sub.sep(q.second)= q.first;
+      SparseMatrix<S> a(ni, ni);
+      a.setFromTriplets(ta.begin(), ta.end());
+      sub.a= make_unique<Ldlt<S>>(a);
+      sub.c.resize(ni, na);
+      sub.c.setFromTriplets(tc.begin(), tc.end());
+      // Contribution is -C^T A^-1 C, formed few columns at time.
+      for(int q0= 0; q0 < na; q0+= chunk) {
+        int const nq= std::min(chunk, na - q0);
+        Mat const cq= Mat(sub.c.middleCols(q0, nq));
+        Mat const x = sub.a->solve(cq);
+        Mat const sc= sub.c.transpose() * x;
+        for(int q= 0; q < nq; ++q) {
+          int const col= sub.sep(q0 + q);
+          for(int p= 0; p < na; ++p) {
+            S const v= sc(p, q);
+            if(v != S(0)) contrib[s].push_back({sub.sep(p), col, -v});
+          }
+        }
+      }
+    });
+    // Assemble Schur-complement from separator's own matrix and every
+    // contribution.
+    vector<Triplet<S>> ts;
+    for(int k= 0; k < ms; ++k) {
+      for(It it(m, sep[k]); it; ++it) {
+        int const j= int(it.row());
+        if(part(j) < 0) ts.push_back({local(j), k, it.value()});
+      }
+    }
+    for(auto &t: contrib) {
+      ts.insert(ts.end(), t.begin(), t.end());
+      vector<Triplet<S>>().swap(t);
+    }
+    SparseMatrix<S> sc(ms, ms);
+    sc.setFromTriplets(ts.begin(), ts.end());
+    ArrayX2i const sxy= xy(lv.sep, Eigen::all);
+    xy                = sxy;
+    levels_.push_back(std::move(lv));
+    return sc;
+  }
+
+public:
+  /// Block-size of first level, unless caller give another.  Block-size is
+  /// fixed, rather than chosen by number of threads, so that solution does
+  /// not depend on machine.
+  static constexpr int defaultBlock= 32;
+
+  /// Scratch for solve().  Caller that keeps workspace from call to call
+  /// allocates nothing once shapes of right-hand sides settle.
+  struct Workspace {
+    vector<Mat>             g;   ///< Right-hand side of each level.
+    vector<Mat>             x;   ///< Solution of each level.
+    vector<vector<SubWork>> sub; ///< Scratch for each square of each level.
+  };
+
+  /// Decompose every level.
+  /// \param coords  Coordinates of each filled pixel, as in Fill::coords().
+  /// \param lrtb    Neighbors of each filled pixel, as in Fill::lrtb().
+  /// \param block   Number of rows and columns between separators at first
+  ///                level.
+  Schur(ArrayX2i const &coords, ArrayX4i const &lrtb, int block= defaultBlock):
+      n_(int(coords.rows())) {
+    // Five-point Laplacian over filled pixels.
+    vector<Triplet<S>> ta;
+    ta.reserve(std::size_t(n_) * 5);
+    for(int i= 0; i < n_; ++i) {
+      ta.push_back({i, i, S(4)});
+      for(int d= 0; d < 4; ++d) {
+        if(lrtb(i, d) >= 0) ta.push_back({i, lrtb(i, d), S(-1)});
+      }
+    }
+    SparseMatrix<S> m(n_, n_);
+    m.setFromTriplets(ta.begin(), ta.end());
+    vector<Triplet<S>>().swap(ta);
+    // Past farthest row and column, every unknown is in one square.
+    ArrayX2i      xy = coords;
+    int64_t const far= (n_ ? xy.maxCoeff() : 0);
+    for(int64_t b= block; m.rows() > 0; b*= 2) {
+      m= dissect(m, xy, b > far ? 0 : b);
+    }
+  }
+
+  /// Number of levels.
+  /// \return  Number of levels.
+  int levels() const { return int(levels_.size()); }
+
+  /// Number of subdomains at first level.
+  /// \return  Number of subdomains at first level.
+  int subdomains() const {
+    return levels_.empty() ? 0 : int(levels_[0].subs.size());
+  }
+
+  /// Number of pixels in separator at first level.
+  /// \return  Number of pixels in separator at first level.
+  int separator() const {
+    return levels_.empty() ? 0 : int(levels_[0].sep.size());
+  }
+
+  /// Number of nonzeros in every decomposition.
+  /// \return  Number of nonzeros in every decomposition.
+  int64_t nonZeros() const {
+    int64_t n= 0;
+    for(Level const &lv: levels_) {
+      for(Sub const &sub: lv.subs) n+= sub.a->nonZeros();
+    }
+    return n;
+  }
+
+  /// Solve for every column of `b`.
+  /// \tparam B  Type of matrix of right-hand sides.
+  /// \param  b  Right-hand sides, one per column and one row per filled pixel.
+  /// \return    Solutions, one per column.
+  template<typename B> Mat solve(B const &b) const {
+    Mat       x;
+    Workspace w;
+    solve(b, x, w);
+    return x;
+  }
+
+  /// Solve for every column of `b` into `x`, by way of workspace.  Neither
+  /// `x` nor workspace is reallocated if its shape already be right.
+  /// \tparam B  Type of matrix of right-hand sides.
+  /// \tparam X  Type of matrix of solutions.
+  /// \param  b  Right-hand sides, one per column and one row per filled pixel.
+  /// \param  x  Solutions, one per column, on return.
+  /// \param  w  Workspace.
+  template<typename B, typename X>
+  void solve(B const &b, X &x, Workspace &w) const {
+    int const nl= int(levels_.size());
+    int const nc= int(b.cols());
+    x.resize(n_, nc);
+    w.g.resize(nl);
+    w.x.resize(nl);
+    w.sub.resize(nl);
+    // Eliminate interiors, level by level upward.  Right-hand side of first
+    // level is `b`.
+    for(int L= 0; L < nl; ++L) {
+      if(L == 0) eliminate(0, b, w);
+      else eliminate(L, w.g[L], w);
+    }
+    // Back-solve interiors, level by level downward.
+    for(int L= nl - 1; L >= 0; --L) {
+      if(L == 0) backSolve(0, b, x, w);
+      else backSolve(L, w.g[L], w.x[L], w);
+    }
+  }
+
+private:
+  /// Solve interior of each square at level, and subtract its coupling from
+  /// right-hand side of level above.
+  /// \tparam G  Type of matrix of right-hand sides.
+  /// \param  L  Offset of level.
+  /// \param  g  Right-hand sides of level.
+  /// \param  w  Workspace.
+  template<typename G>
+  void eliminate(int L, G const &g, Workspace &w) const {
+    using Eigen::all;
+    Level const &lv= levels_[L];
+    auto        &ws= w.sub[L];
+    int const    ns= int(lv.subs.size());
+    ws.resize(ns);
+    ThreadPool::global().run(ns, [&](int s) {
+      Sub const &sub= lv.subs[s];
+      SubWork   &sw = ws[s];
+      sw.r          = g(view(sub.rows), all);
+      sub.a->solve(sw.r, sw.y, sw.t);
+      sw.u.noalias()= sub.c.transpose() * sw.y;
+    });
+    if(L + 1 == int(levels_.size())) return;
+    Mat &gs= w.g[L + 1];
+    gs     = g(view(lv.sep), all);
+    for(int s= 0; s < ns; ++s) gs(view(lv.subs[s].sep), all)-= ws[s].u;
+  }
+
+  /// Solve level, given solution of level above.
+  /// \tparam G  Type of matrix of right-hand sides.
+  /// \tparam X  Type of matrix of solutions.
+  /// \param  L  Offset of level.
+  /// \param  g  Right-hand sides of level.
+  /// \param  x  Solutions of level, on return.
+  /// \param  w  Workspace.
+  template<typename G, typename X>
+  void backSolve(int L, G const &g, X &x, Workspace &w) const {
+    using Eigen::all;
+    Level const &lv= levels_[L];
+    auto        &ws= w.sub[L];
+    int const    ns= int(lv.subs.size());
+    x.resize(lv.n, g.cols());
+    if(L + 1 == int(levels_.size())) {
+      // Interiors of top level were solved on way up.
+      for(int s= 0; s < ns; ++s) x(view(lv.subs[s].rows), all)= ws[s].y;
+      return;
+    }
+    Mat const &xs = w.x[L + 1];
+    x(view(lv.sep), all)= xs;
+    ThreadPool::global().run(ns, [&](int s) {
+      Sub const &sub= lv.subs[s];
+      SubWork   &sw = ws[s];
+      sw.u          = xs(view(sub.sep), all);
+      sw.r          = g(view(sub.rows), all);
+      sw.r.noalias()-= sub.c * sw.u;
+      sub.a->solve(sw.r, sw.y, sw.t);
+      x(view(sub.rows), all)= sw.y;
+    });
+  }
+};
+
+
+} // namespace dirichlet::impl
+
+#endif // ndef DIRICHLET_IMPL_SCHUR_HPP
+
+// EOF
@@ -0,0 +1,196 @@
+/// \file       include/dirichlet/impl/ThreadPool.hpp
+/// \copyright  2022 Thomas E. Vaughan.  See terms in LICENSE.
+/// \brief      Definition of dirichlet::impl::ThreadPool.
+
+#ifndef DIRICHLET_IMPL_THREAD_POOL_HPP
+#define DIRICHLET_IMPL_THREAD_POOL_HPP
+
+#include <atomic>             // atomic
+#include <condition_variable> // condition_variable
+#include <exception>          // exception_ptr, current_exception
+#include <mutex>              // mutex, unique_lock, lock_guard
+#include <thread>             // thread
+#include <vector>             // vector
+
+namespace dirichlet::impl {
+
+
+using std::atomic;
+using std::condition_variable;
+using std::exception_ptr;
+using std::lock_guard;
+using std::mutex;
+using std::thread;
+using std::unique_lock;
+using std::vector;
+
+
+/// Persistent pool of worker-threads for running independent tasks, each
+/// identified by offset, in parallel.
+///
+/// Workers are started once and sleep between jobs, so that cost of each job
+/// is little more than cost of waking workers.  Calling thread participates in
+/// job, and tasks are handed out one at a time by atomic counter, so that
+/// large and small tasks balance across threads.
+class ThreadPool {
+  vector<thread>     threads_;      ///< Workers, not counting caller.
+  mutex              mutex_;        ///< Protect state shared with workers.
+  mutex              runMutex_;     ///< Allow only one job at a time.
+  condition_variable wake_;         ///< Signal workers that job is ready.
+  condition_variable done_;         ///< Signal caller that workers finished.
+  atomic<int>        next_;         ///< Offset of next task to hand out.
+  int                n_   = 0;      ///< Number of tasks in current job.
+  unsigned           gen_ = 0;      ///< Number of job, incremented by run().
+  unsigned           idle_= 0;      ///< Number of workers finished with job.
+  bool               stop_= false;  ///< True when workers should exit.
+  exception_ptr      error_;        ///< First exception thrown by any task.
+
+  /// Type-erased job.  First argument is pointer to function-object.
+  void (*call_)(void const *, int)= nullptr;
+
+  /// Pointer to function-object for current job.
+  void const *job_= nullptr;
+
+  /// True in thread that is running task from any pool.
+  /// \return  Reference to thread-local flag.
+  static bool &inTask() {
+    static thread_local bool flag= false;
+    return flag;
+  }
+
+  /// Offset of worker, starting at one, in thread that is worker of pool, or
+  /// zero in any other thread.
+  /// \return  Reference to thread-local offset.
+  static unsigned &slotRef() {
+    static thread_local unsigned s= 0;
+    return s;
+  }
+
+  /// Run tasks until none be left in current job.
+  void work() {
+    bool &flag= inTask();
+    flag      = true;
+    for(int i= next_++; i < n_; i= next_++) {
+      try {
+        call_(job_, i);
+      } catch(...) {
+        lock_guard<mutex> lock(mutex_);
+        if(!error_) error_= std::current_exception();
+      }
+    }
+    flag= false;
+  }
+
+  /// Loop run by each worker.
+  void loop() {
+    unsigned seen= 0;
+    for(;;) {
+      {
+        unique_lock<mutex> lock(mutex_);
+        wake_.wait(lock, [&] { return stop_ || gen_ != seen; });
+        if(stop_) return;
+        seen= gen_;
+      }
+      work();
+      lock_guard<mutex> lock(mutex_);
+      if(++idle_ == threads_.size()) done_.notify_one();
+    }
+  }
+
+public:
+  /// Start workers.
+  /// \param nThreads  Number of workers, not including caller of run().
+  explicit ThreadPool(unsigned nThreads) {
+    threads_.reserve(nThreads);
+    for(unsigned i= 0; i < nThreads; ++i) {
+      threads_.emplace_back([this, i] {
+        slotRef()= i + 1;
+        loop();
+      });
+    }
+  }
+
+  /// Stop and join workers.
+  ~ThreadPool() {
+    {
+      lock_guard<mutex> lock(mutex_);
+      stop_= true;
+    }
+    wake_.notify_all();
+    for(auto &t: threads_) t.join();
+  }
+
+  ThreadPool(ThreadPool const &)= delete;
+  ThreadPool &operator=(ThreadPool const &)= delete;
+
+  /// Number of threads, including caller, that run tasks.
+  /// \return  Number of threads that run tasks.
+  unsigned size() const { return unsigned(threads_.size()) + 1; }
+
+  /// Offset, less than size(), of calling thread in pool: zero for caller of
+  /// run(), and different for each worker.  No two threads running tasks of
+  /// same job have same offset, so task may index per-thread workspace by
+  /// slot().
+  /// \return  Offset of calling thread.
+  static unsigned slot() { return slotRef(); }
+
+  /// Call `f(i)` for each `i` in `[0, n)`, in parallel, and return when every
+  /// call has returned.
+  ///
+  /// If called from within task, then run every call serially in calling
+  /// thread.  If any call throw exception, then rethrow first exception after
+  /// every other call has returned.
+  ///
+  /// \tparam F  Type of function-object.
+  /// \param  n  Number of tasks.
+  /// \param  f  Function-object to call for each task.
+  template<typename F> void run(int n, F const &f) {
+    if(n <= 0) return;
+    if(n == 1 || threads_.empty() || inTask()) {
+      for(int i= 0; i < n; ++i) f(i);
+      return;
+    }
+    lock_guard<mutex> runLock(runMutex_);
+    {
+      lock_guard<mutex> lock(mutex_);
+      call_= [](void const *j, int i) { (*static_cast<F const *>(j))(i); };
+      job_ = &f;
+      n_   = n;
+      next_= 0;
+      idle_= 0;
+      ++gen_;
+    }
+    wake_.notify_all();
+    work();
+    unique_lock<mutex> lock(mutex_);
+    // Wait for every worker, even one that got no task, so that none may see
+    // job_ after it has gone out of scope.
+    done_.wait(lock, [&] { return idle_ == threads_.size(); });
+    if(error_) {
+      exception_ptr e= error_;
+      error_         = nullptr;
+      std::rethrow_exception(e);
+    }
+  }
+
+  /// Pool shared by every instance of every class in library.
+  ///
+  /// Pool has one fewer worker than number of hardware-threads, because
+  /// caller of run() participates.
+  ///
+  /// \return  Reference to shared pool.
+  static ThreadPool &global() {
+    static ThreadPool pool(
+          thread::hardware_concurrency() > 1
+                ? thread::hardware_concurrency() - 1
+                : 0);
+    return pool;
+  }
+};
+
+
+} // namespace dirichlet::impl
+
+#endif // ndef DIRICHLET_IMPL_THREAD_POOL_HPP
+
+// EOF
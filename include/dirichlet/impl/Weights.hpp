@@ -5,106 +5,81 @@
 #ifndef DIRICHLET_IMPL_WEIGHTS_HPP
 #define DIRICHLET_IMPL_WEIGHTS_HPP
 
-#include <cstdint>            // uint64_t
-#include <eigen3/Eigen/Dense> // ArrayXX
-#include <vector>             // vector
+#include <cstdint>            // int32_t
+#include <eigen3/Eigen/Dense> // Array
 
 namespace dirichlet::impl {
 
 
-using Eigen::ArrayXX;
-using Eigen::InnerStride;
-using Eigen::Unaligned;
-using std::vector;
+using Eigen::Dynamic;
+using Eigen::RowMajor;
 
 
-/// For each pixel in image, store value for each of left, right, top, bottom,
-/// and center of cruciform pattern of weights for use in solving
-/// Dirichlet-problem.  Each weight is stored as two-byte integer.
+/// For each unknown in linear problem, store value for each of left, right,
+/// top, bottom, and center of cruciform pattern of weights for use in solving
+/// Dirichlet-problem.
+///
+/// Storage is proportional to number of unknowns rather than to size of
+/// image.  Each weight is stored as four-byte integer, so that weight of pixel
+/// on edge of large square does not overflow.
 class Weights {
-  vector<uint64_t> s_; ///< Storage-space for weights.
-  int              h_; ///< Height of image.
-  int              w_; ///< Width of image.
-
+public:
   /// Type for each weight.
-  using W= int16_t;
-
-  /// Number of `uint64_t` words needed for storing `nWeights` weights.
-  /// \param nWeights  Number of weights to store.
-  /// \return          Number of `uint64_t` needed for `nWeights` weights.
-  static int nWords(int nWeights) {
-    return sizeof(W) * nWeights / sizeof(uint64_t) + 1;
-  }
+  using W= int32_t;
 
+private:
   /// Offset of each weight.
   enum WeightOffset { LFT, RGT, TOP, BOT, CEN, NUM_WEIGHTS };
 
-  /// Stride for same weight in subsequent elements.
-  using Stride= InnerStride<NUM_WEIGHTS>;
-
-  /// Type of array for non-const element.
-  using Map= Eigen::Map<ArrayXX<W>, Unaligned, Stride>;
-
-  /// Type of array for const element.
-  using ConstMap= Eigen::Map<ArrayXX<W> const, Unaligned, Stride>;
-
-  /// Expression-template for weight at specified offset.
-  /// \param off  Offset of weight in pattern.
-  /// \return     Expression template for array of weights at same offset.
-  auto weight(int off) {
-    W *first= ((W *)&s_[0]) + off;
-    return Map(first, h_, w_);
-  }
-
-  /// Expression-template for weight at specified offset.
-  /// \param off  Offset of weight in pattern.
-  /// \return     Expression template for array of weights at same offset.
-  auto weight(int off) const {
-    W const *first= ((W const *)&s_[0]) + off;
-    return ConstMap(first, h_, w_);
-  }
+  /// Weights of each unknown, contiguous in row.
+  Eigen::Array<W, Dynamic, NUM_WEIGHTS, RowMajor> s_;
 
 public:
   /// Initialize all weights to zero.
-  /// \param h  Height of image.
-  /// \param w  Width  of image.
-  Weights(int h, int w): s_(nWords(NUM_WEIGHTS * h * w), 0), h_(h), w_(w) {}
+  /// \param n  Number of unknowns.
+  explicit Weights(int n= 0): s_(decltype(s_)::Zero(n, NUM_WEIGHTS)) {}
+
+  /// Set every weight of unknown.
+  /// \param i  Offset of unknown.
+  /// \param l  Left   weight.
+  /// \param r  Right  weight.
+  /// \param t  Top    weight.
+  /// \param b  Bottom weight.
+  /// \param c  Center weight.
+  void set(int i, W l, W r, W t, W b, W c) { s_.row(i) << l, r, t, b, c; }
 
   /// Expression-template for left weight.
-  auto lft() { return weight(LFT); }
+  auto lft() { return s_.col(LFT); }
 
   /// Expression-template for right weight.
-  auto rgt() { return weight(RGT); }
+  auto rgt() { return s_.col(RGT); }
 
   /// Expression-template for top weight.
-  auto top() { return weight(TOP); }
+  auto top() { return s_.col(TOP); }
 
   /// Expression-template for bottom weight.
-  auto bot() { return weight(BOT); }
+  auto bot() { return s_.col(BOT); }
 
   /// Expression-template for center weight.
-  auto cen() { return weight(CEN); }
+  auto cen() { return s_.col(CEN); }
 
   /// Expression-template for left weight.
-  auto lft() const { return weight(LFT); }
+  auto lft() const { return s_.col(LFT); }
 
   /// Expression-template for right weight.
-  auto rgt() const { return weight(RGT); }
+  auto rgt() const { return s_.col(RGT); }
 
   /// Expression-template for top weight.
-  auto top() const { return weight(TOP); }
+  auto top() const { return s_.col(TOP); }
 
   /// Expression-template for bottom weight.
-  auto bot() const { return weight(BOT); }
+  auto bot() const { return s_.col(BOT); }
 
   /// Expression-template for center weight.
-  auto cen() const { return weight(CEN); }
-
-  /// Height of image.
-  int h() const { return h_; }
+  auto cen() const { return s_.col(CEN); }
 
-  /// Width of image.
-  int w() const { return w_; }
+  /// Number of unknowns.
+  int size() const { return int(s_.rows()); }
 };
 
 
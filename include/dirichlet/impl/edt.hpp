@@ -0,0 +1,87 @@
+/// \file       include/dirichlet/impl/edt.hpp
+/// \copyright  2022 Thomas E. Vaughan.  See terms in LICENSE.
+/// \brief      Definition of dirichlet::impl::edt().
+
+#ifndef DIRICHLET_IMPL_EDT_HPP
+#define DIRICHLET_IMPL_EDT_HPP
+
+#include <algorithm>          // min
+#include <cstdint>            // int64_t
+#include <eigen3/Eigen/Dense> // ArrayXX, ArrayXXi
+#include <limits>             // numeric_limits
+#include <vector>             // vector
+
+namespace dirichlet::impl {
+
+
+using Eigen::ArrayXX;
+using Eigen::ArrayXXi;
+
+
+/// Exact, squared Euclidean distance from each true element of `a` to nearest
+/// element that is either false or beyond edge of `a`.
+///
+/// Distance along each column is found first, and then lower envelope of
+/// parabolas along each row gives exact distance in two dimensions, in time
+/// linear in number of elements (Felzenszwalb and Huttenlocher).
+///
+/// \param  a  Array of boolean, true for each element to be measured.
+/// \return    Squared distance for each element, zero for each false element.
+///
+inline ArrayXXi edt(ArrayXX<bool> const &a) {
+  int const nr= int(a.rows());
+  int const nc= int(a.cols());
+  ArrayXXi  d(nr, nc);
+  if(nr == 0 || nc == 0) return d;
+  // Distance along each column, to false element or to edge.
+  for(int c= 0; c < nc; ++c) {
+    int g= 0;
+    for(int r= 0; r < nr; ++r) d(r, c)= g= (a(r, c) ? g + 1 : 0);
+    g= 0;
+    for(int r= nr - 1; r >= 0; --r) {
+      g      = (a(r, c) ? g + 1 : 0);
+      d(r, c)= std::min(d(r, c), g);
+    }
+  }
+  // Lower envelope of parabolas along each row.
+  double const         inf= std::numeric_limits<double>::infinity();
+  std::vector<int>     v(nc);     // Column of each parabola in envelope.
+  std::vector<double>  z(nc + 1); // Boundaries between parabolas.
+  std::vector<int64_t> f(nc);     // Squared distance along column.
+  // Parabola at q crosses parabola at p.
+  auto const cross= [&f](int64_t q, int64_t p) {
+    return double(f[q] + q * q - f[p] - p * p) / double(2 * (q - p));
+  };
+  for(int r= 0; r < nr; ++r) {
+    for(int c= 0; c < nc; ++c) f[c]= int64_t(d(r, c)) * d(r, c);
+    int k= 0;
+    v[0] = 0;
+    z[0] = -inf;
+    z[1] = +inf;
+    for(int q= 1; q < nc; ++q) {
+      double s= cross(q, v[k]);
+      // Boundary at z[0] is minus infinity, so that k stays nonnegative.
+      while(s <= z[k]) s= cross(q, v[--k]);
+      ++k;
+      v[k]    = q;
+      z[k]    = s;
+      z[k + 1]= +inf;
+    }
+    k= 0;
+    for(int q= 0; q < nc; ++q) {
+      while(z[k + 1] < q) ++k;
+      int64_t const dq= q - v[k];
+      // Edge of array, beyond each end of row, is also false.
+      int64_t const e= std::min(int64_t(q) + 1, int64_t(nc) - q);
+      d(r, q)        = int(std::min(dq * dq + f[v[k]], e * e));
+    }
+  }
+  return d;
+}
+
+
+} // namespace dirichlet::impl
+
+#endif // ndef DIRICHLET_IMPL_EDT_HPP
+
+// EOF
@@ -0,0 +1,105 @@
+/// \file       include/dirichlet/impl/ldltSolve.hpp
+/// \copyright  2022 Thomas E. Vaughan.  See terms in LICENSE.
+/// \brief      Definition of dirichlet::impl::ldltSolve().
+
+#ifndef DIRICHLET_IMPL_LDLT_SOLVE_HPP
+#define DIRICHLET_IMPL_LDLT_SOLVE_HPP
+
+#include <eigen3/Eigen/Sparse> // Matrix
+
+namespace dirichlet::impl {
+
+
+using Eigen::Dynamic;
+using Eigen::Matrix;
+using Eigen::RowMajor;
+
+
+/// Solve linear system for every column of `b` against LDLT-decomposition
+/// `ldlt`, and pass only once over factor.
+///
+/// Eigen's own solve passes over whole factor once for each column of `b`.
+/// Here, instead, each nonzero coefficient of factor is read once and applied
+/// to one row of (row-major) right-hand sides.  Because back-substitution is
+/// limited by bandwidth for reading factor, solving for three or four colors
+/// at once costs little more than solving for one.
+///
+/// Solution is written into `x` by way of row-major workspace `y`.  Neither
+/// is reallocated if it already be of right shape, so that caller who keeps
+/// both from call to call allocates nothing.
+///
+/// \tparam L     Type of decomposition (like impl::Ldlt), with `l()` for
+///               column-major, unit-lower factor, `d()` for diagonal, and
+///               `p()` for indices of permutation (empty if none).
+/// \tparam B     Type of matrix of right-hand sides.
+/// \tparam X     Type of matrix of solutions.
+/// \param  ldlt  Decomposition of square matrix.
+/// \param  b     Right-hand sides, one per column.
+/// \param  x     Solutions, one per column, on return.
+/// \param  y     Workspace.
+///
+template<typename L, typename B, typename X>
+void ldltSolve(
+      L const                                             &ldlt,
+      B const                                             &b,
+      X                                                   &x,
+      Matrix<typename L::Scalar, Dynamic, Dynamic, RowMajor> &y) {
+  using Eigen::all;
+  auto const m= ldlt.l();
+  auto const d= ldlt.d();
+  auto const p= ldlt.p();
+  using It    = typename decltype(m)::InnerIterator;
+  int const n = int(m.outerSize());
+  y.resize(b.rows(), b.cols());
+  if(p.size() > 0) {
+    y(p, all)= b; // y = P b
+  } else {
+    y= b;
+  }
+  // Forward substitution: L y = P b.
+  for(int j= 0; j < n; ++j) {
+    for(It it(m, j); it; ++it) {
+      if(it.index() > j) y.row(it.index())-= it.value() * y.row(j);
+    }
+  }
+  // Diagonal.
+  y.array().colwise()/= d.array();
+  // Backward substitution: L^T z = D^-1 y.
+  for(int j= n - 1; j >= 0; --j) {
+    for(It it(m, j); it; ++it) {
+      if(it.index() > j) y.row(j)-= it.value() * y.row(it.index());
+    }
+  }
+  if(p.size() > 0) {
+    x= y(p, all); // P^-1 z
+  } else {
+    x= y;
+  }
+}
+
+
+/// Solve linear system for every column of `b` against LDLT-decomposition
+/// `ldlt`, as above, into new matrix.
+///
+/// \tparam L     Type of decomposition.
+/// \tparam B     Type of matrix of right-hand sides.
+/// \param  ldlt  Decomposition of square matrix.
+/// \param  b     Right-hand sides, one per column.
+/// \return       Solutions, one per column.
+///
+template<typename L, typename B>
+Matrix<typename L::Scalar, Dynamic, Dynamic>
+ldltSolve(L const &ldlt, B const &b) {
+  using S= typename L::Scalar;
+  Matrix<S, Dynamic, Dynamic>           x;
+  Matrix<S, Dynamic, Dynamic, RowMajor> y;
+  ldltSolve(ldlt, b, x, y);
+  return x;
+}
+
+
+} // namespace dirichlet::impl
+
+#endif // ndef DIRICHLET_IMPL_LDLT_SOLVE_HPP
+
+// EOF
@@ -0,0 +1,141 @@
+/// \file       include/dirichlet/impl/maskScan.hpp
+/// \copyright  2022 Thomas E. Vaughan.  See terms in LICENSE.
+/// \brief      Definition of dirichlet::impl::forEachNonZero() and
+///             dirichlet::impl::forEachSetBit().
+
+#ifndef DIRICHLET_IMPL_MASK_SCAN_HPP
+#define DIRICHLET_IMPL_MASK_SCAN_HPP
+
+#include "simd.hpp" // simd
+#include <cstdint>  // uint8_t, uint32_t, uint64_t
+#include <cstring>  // memcpy
+
+namespace dirichlet::impl {
+
+
+/// Call `f(c)` for each set bit `c` of `bits`, in ascending order.
+/// \tparam F     Type of function-object.
+/// \param  bits  Bits.
+/// \param  base  Number added to offset of each bit.
+/// \param  f     Function-object.
+template<typename F>
+inline void forEachBit(uint64_t bits, int base, F const &f) {
+  while(bits) {
+    f(base + __builtin_ctzll(bits));
+    bits&= bits - 1;
+  }
+}
+
+
+#ifdef DIRICHLET_X86
+/// Call `f(c)` for each non-zero byte in `[b, e)`, sixty-four bytes at a time,
+/// by AVX-512BW.
+/// \tparam F    Type of function-object.
+/// \param  row  Pointer to first byte of row.
+/// \param  b    Offset of first byte to scan.
+/// \param  e    Offset past last byte to scan.
+/// \param  f    Function-object.
+/// \return      Offset of first byte not scanned.
+template<typename F>
+__attribute__((target("avx512bw"))) int
+scanAvx512(uint8_t const *row, int b, int e, F const &f) {
+  int c= b;
+  for(; c + 64 <= e; c+= 64) {
+    __m512i const v= _mm512_loadu_si512(row + c);
+    forEachBit(_mm512_test_epi8_mask(v, v), c, f);
+  }
+  return c;
+}
+
+
+/// Call `f(c)` for each non-zero byte in `[b, e)`, thirty-two bytes at a time,
+/// by AVX2.
+/// \tparam F    Type of function-object.
+/// \param  row  Pointer to first byte of row.
+/// \param  b    Offset of first byte to scan.
+/// \param  e    Offset past last byte to scan.
+/// \param  f    Function-object.
+/// \return      Offset of first byte not scanned.
+template<typename F>
+__attribute__((target("avx2"))) int
+scanAvx2(uint8_t const *row, int b, int e, F const &f) {
+  __m256i const zero= _mm256_setzero_si256();
+  int           c   = b;
+  for(; c + 32 <= e; c+= 32) {
+    __m256i const v= _mm256_loadu_si256((__m256i const *)(row + c));
+    __m256i const z= _mm256_cmpeq_epi8(v, zero);
+    forEachBit(~uint32_t(_mm256_movemask_epi8(z)), c, f);
+  }
+  return c;
+}
+#endif
+
+
+/// Call `f(c)` for each `c` in `[b, e)` at which byte `row[c]` is non-zero,
+/// in ascending order.
+///
+/// Zero bytes are skipped many at a time: sixty-four on processor with
+/// AVX-512BW, thirty-two with AVX2, and otherwise eight by way of 64-bit word.
+/// Variant is chosen at run time by simd(), whatever flags be given to
+/// compiler.  So cost of scan is little more than cost of reading mask when
+/// mask is mostly zero.
+///
+/// \tparam F    Type of function-object.
+/// \param  row  Pointer to first byte of row.
+/// \param  b    Offset of first byte to scan.
+/// \param  e    Offset past last byte to scan.
+/// \param  f    Function-object.
+template<typename F>
+void forEachNonZero(uint8_t const *row, int b, int e, F const &f) {
+  int c= b;
+#ifdef DIRICHLET_X86
+  switch(simd()) {
+  case Simd::AVX512: c= scanAvx512(row, b, e, f); break;
+  case Simd::AVX2: c= scanAvx2(row, b, e, f); break;
+  case Simd::SCALAR: break;
+  }
+#endif
+  for(; c + 8 <= e; c+= 8) {
+    uint64_t w;
+    std::memcpy(&w, row + c, 8);
+    if(w == 0) continue;
+    for(int k= 0; k < 8; ++k) {
+      if(row[c + k]) f(c + k);
+    }
+  }
+  for(; c < e; ++c) {
+    if(row[c]) f(c);
+  }
+}
+
+
+/// Call `f(c)` for each `c` in `[b, e)` at which bit is set in bit-packed row,
+/// in ascending order.  Bit for column `c` is bit `c % 64` (counting from
+/// least significant) of word `c / 64`.  Zero words are skipped sixty-four
+/// columns at a time.
+///
+/// \tparam F      Type of function-object.
+/// \param  words  Pointer to first word of row.
+/// \param  b      Offset of first column to scan.
+/// \param  e      Offset past last column to scan.
+/// \param  f      Function-object.
+template<typename F>
+void forEachSetBit(uint64_t const *words, int b, int e, F const &f) {
+  if(b >= e) return;
+  int const first= b / 64;
+  int const last = (e - 1) / 64;
+  for(int k= first; k <= last; ++k) {
+    uint64_t w= words[k];
+    if(w == 0) continue;
+    if(k == first) w&= ~uint64_t(0) << (b % 64);
+    if(k == last && e % 64) w&= ~(~uint64_t(0) << (e % 64));
+    forEachBit(w, k * 64, f);
+  }
+}
+
+
+} // namespace dirichlet::impl
+
+#endif // ndef DIRICHLET_IMPL_MASK_SCAN_HPP
+
+// EOF
@@ -0,0 +1,76 @@
+/// \file       include/dirichlet/impl/simd.hpp
+/// \copyright  2022 Thomas E. Vaughan.  See terms in LICENSE.
+/// \brief      Definition of dirichlet::impl::simd() and
+///             dirichlet::impl::setSimdLimit().
+
+#ifndef DIRICHLET_IMPL_SIMD_HPP
+#define DIRICHLET_IMPL_SIMD_HPP
+
+#include <atomic> // atomic
+
+// Vectorized kernels are compiled, by way of target-attribute, whatever flags
+// be given to compiler, and one is chosen at run time.
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#define DIRICHLET_X86 1
+#include <immintrin.h> // _mm256_*, _mm512_*
+#endif
+
+namespace dirichlet::impl {
+
+
+/// Level of vector-instructions for kernel that has vectorized variant.
+enum class Simd {
+  SCALAR, ///< No vector-instructions.
+  AVX2,   ///< 256-bit AVX2.
+  AVX512  ///< 512-bit AVX-512F and AVX-512BW.
+};
+
+
+/// Highest level supported by processor.
+/// \return  Highest level supported by processor.
+inline Simd simdSupported() {
+#ifdef DIRICHLET_X86
+  static Simd const s= [] {
+    bool const f = __builtin_cpu_supports("avx512f");
+    bool const bw= __builtin_cpu_supports("avx512bw");
+    if(f && bw) return Simd::AVX512;
+    if(__builtin_cpu_supports("avx2")) return Simd::AVX2;
+    return Simd::SCALAR;
+  }();
+  return s;
+#else
+  return Simd::SCALAR;
+#endif
+}
+
+
+/// Highest level that any kernel may use; by default, highest level
+/// supported.
+/// \return  Limit, shared by every thread.
+inline std::atomic<Simd> &simdLimit() {
+  static std::atomic<Simd> limit(simdSupported());
+  return limit;
+}
+
+
+/// Lower (or restore) highest level that any kernel may use, so that, for
+/// example, each vectorized variant can be compared with scalar code in same
+/// build.  Level is never raised above that supported by processor.
+/// \param s  Limit.
+inline void setSimdLimit(Simd s) { simdLimit()= s; }
+
+
+/// Level to be used by kernel.
+/// \return  Lower of limit and of level supported by processor.
+inline Simd simd() {
+  Simd const s= simdLimit();
+  Simd const h= simdSupported();
+  return (s < h ? s : h);
+}
+
+
+} // namespace dirichlet::impl
+
+#endif // ndef DIRICHLET_IMPL_SIMD_HPP
+
+// EOF
@@ -2,15 +2,23 @@
 /// \copyright  2022 Thomas E. Vaughan.  See terms in LICENSE.
 /// \brief      Tests for dirichlet::FillBiLin.
 
-#include "dirichlet/FillBiLin.hpp"      // FillBiLin
-#include "image1.hpp"                   // image1, mask1, etc.
-#include "mask2.hpp"                    // mask2, etc.
-#include "mask3.hpp"                    // mask3, etc.
-#include "pgm.hpp"                      // Image, drawMask(), test::pgm
-#include <catch2/catch_test_macros.hpp> // TEST_CASE
-#include <chrono>                       // steady_clock
-#include <fstream>                      // ifstream, ofstream
-#include <iostream>                     // cout, endl
+#include "dirichlet/Fill.hpp"             // Fill
+#include "dirichlet/FillBiLin.hpp"        // FillBiLin
+#include "dirichlet/impl/bin2x2.hpp"      // bin2x2()
+#include "dirichlet/impl/unbin2x2.hpp"    // unbin2x2()
+#include "dirichlet/impl/validSquare.hpp" // validSquare()
+#include "image1.hpp"                     // image1, mask1, etc.
+#include "mask2.hpp"                      // mask2, etc.
+#include "mask3.hpp"                      // mask3, etc.
+#include "pgm.hpp"                        // Image, drawMask(), test::pgm
+#include <algorithm>                      // count
+#include <catch2/catch_test_macros.hpp>   // TEST_CASE
+#include <chrono>                         // steady_clock
+#include <cmath>                          // atan2, cos
+#include <fstream>                        // ifstream, ofstream
+#include <iostream>                       // cout, endl
+#include <thread>                         // thread
+#include <vector>                         // vector
 
 using dirichlet::FillBiLin;
 using std::array;
@@ -74,13 +82,14 @@ TEST_CASE("mask1 works on construction.", "[FillBiLin]") {
 
 TEST_CASE("image1 works with mask1.", "[FillBiLin]") {
   enum { R=12, C=12 };
-  FillBiLin f(mask1, R, C);
+  FillBiLin const   f(mask1, R, C);
   array<int, R * C> im1= image1;
   cout << "image1 before:\n";
   print(im1.begin(), R, C);
-  auto im1Old= im1;
-  f(im1.begin());
-  cout << "b1=\n" << f.b().transpose() << endl;
+  auto                 im1Old= im1;
+  FillBiLin::Workspace ws;
+  f(im1.begin(), ws);
+  cout << "b1=\n" << ws.b.transpose() << endl;
   cout << "image1 after:\n";
   print(im1.begin(), R, C);
   cout << "image1 diff:\n";
@@ -167,6 +176,272 @@ TEST_CASE("image3 works with mask3.", "[FillBiLin]") {
 }
 
 
+TEST_CASE("Interior of each square is interpolated.", "[FillBiLin]") {
+  enum { W= 64, H= 64 };
+  std::vector<uint8_t> mask(W * H);
+  std::vector<float>   im(W * H);
+  for(int r= 0; r < H; ++r) {
+    for(int c= 0; c < W; ++c) {
+      bool const in  = (r >= 8 && r < 56 && c >= 8 && c < 56);
+      mask[r * W + c]= in;
+      im[r * W + c]  = (in ? -1.0f : 10.0f + 2.0f * r + 3.0f * c);
+    }
+  }
+  FillBiLin f(mask.data(), W, H);
+  REQUIRE(f.nSquares() > 0);
+  f(im.data());
+  // Every pixel in hole is written.
+  REQUIRE(std::count(im.begin(), im.end(), -1.0f) == 0);
+  // Interior of each square is bilinear between its corners.
+  float most= 0.0f;
+  for(int k= 0; k < f.nSquares(); ++k) {
+    int const   t  = f.corners()(k, 0);
+    int const   l  = f.corners()(k, 1);
+    int const   s  = f.corners()(k, 2) - 1;
+    float const v00= im[t * W + l];
+    float const v01= im[t * W + l + s];
+    float const v10= im[(t + s) * W + l];
+    float const v11= im[(t + s) * W + l + s];
+    for(int r= 1; r < s; ++r) {
+      for(int c= 1; c < s; ++c) {
+        float const y= float(r) / s;
+        float const x= float(c) / s;
+        float const v= (1 - y) * ((1 - x) * v00 + x * v01) +
+                       y * ((1 - x) * v10 + x * v11);
+        most= std::max(most, std::abs(im[(t + r) * W + l + c] - v));
+      }
+    }
+  }
+  REQUIRE(most < 1.0E-2f);
+}
+
+
+TEST_CASE("Symmetric matrix reproduces linear image.", "[FillBiLin]") {
+  enum { W= 64, H= 64 };
+  std::vector<uint8_t> mask(W * H);
+  std::vector<float>   im(W * H);
+  for(int r= 0; r < H; ++r) {
+    for(int c= 0; c < W; ++c) {
+      mask[r * W + c]= (r >= 8 && r < 56 && c >= 8 && c < 56);
+      im[r * W + c]  = 10.0f + 2.0f * r + 3.0f * c;
+    }
+  }
+  FillBiLin f(mask.data(), W, H);
+  REQUIRE(f.nSquares() > 0);
+  Eigen::SparseMatrix<float> const at= f.a().transpose();
+  REQUIRE((f.a() - at).norm() == 0.0f);
+  std::vector<float> const old= im;
+  f(im.data());
+  float most= 0.0f;
+  for(int i= 0; i < W * H; ++i) most= std::max(most, std::abs(im[i] - old[i]));
+  REQUIRE(most < 1.0E-1f);
+}
+
+
+TEST_CASE("Mask is not padded for binning.", "[FillBiLin]") {
+  // Just larger than multiple of power of two, like 4100 = 4096 + 4, for
+  // which padding to multiple of largest binning factor would add a quarter.
+  for(int const n: {68, 100, 260}) {
+    int const            W= (n == 100 ? 70 : n);
+    int const            H= n;
+    std::vector<uint8_t> mask(W * H);
+    std::vector<float>   im(W * H);
+    for(int r= 0; r < H; ++r) {
+      for(int c= 0; c < W; ++c) {
+        mask[r * W + c]= (r >= 10 && r < H - 10 && c >= 10 && c < W - 10);
+        im[r * W + c]  = 10.0f + 2.0f * r + 3.0f * c;
+      }
+    }
+    FillBiLin f(mask.data(), W, H);
+    REQUIRE(f.extendedMask().rows() == H);
+    REQUIRE(f.extendedMask().cols() == W);
+    REQUIRE(f.nSquares() > 0);
+    // Largest square is same as for padded mask, though odd last row and
+    // column of each level of binning are left out.
+    if(n == 260) REQUIRE(f.corners().col(2).maxCoeff() == 32);
+    std::vector<float> const old= im;
+    f(im.data());
+    float most= 0.0f;
+    for(int i= 0; i < W * H; ++i) {
+      most= std::max(most, std::abs(im[i] - old[i]));
+    }
+    // Rounding in single precision grows with size of hole.
+    REQUIRE(most < 1.0E-3f * float(n));
+  }
+}
+
+
+TEST_CASE("Weights are stored per unknown.", "[FillBiLin]") {
+  FillBiLin const f(mask3, 34, 34);
+  auto const     &w= f.weights();
+  REQUIRE(w.size() == f.coords().rows());
+  // Center-weight balances other weights for every unknown, also on edge of
+  // square or of image.
+  auto const sum= w.lft() + w.rgt() + w.top() + w.bot() + w.cen();
+  REQUIRE((sum == 0).all());
+  REQUIRE((w.cen() < 0).all());
+}
+
+
+TEST_CASE("Threads share one instance.", "[FillBiLin]") {
+  enum { W= 64, H= 64, N= 4 };
+  std::vector<uint8_t> mask(W * H);
+  std::vector<float>   im(W * H);
+  for(int r= 0; r < H; ++r) {
+    for(int c= 0; c < W; ++c) {
+      mask[r * W + c]= (r >= 8 && r < 56 && c >= 8 && c < 56);
+      im[r * W + c]  = float((r * 7 + c * 13) % 32);
+    }
+  }
+  FillBiLin const    f(mask.data(), W, H);
+  std::vector<float> expected= im;
+  f(expected.data());
+  // Each thread fills its own copy repeatedly, with its own workspace.
+  std::vector<std::vector<float>> copies(N);
+  std::vector<std::thread>        threads;
+  for(int k= 0; k < N; ++k) {
+    threads.emplace_back([&f, &copies, &im, k] {
+      FillBiLin::Workspace ws;
+      for(int j= 0; j < 8; ++j) {
+        copies[k]= im;
+        f(copies[k].data(), ws);
+      }
+    });
+  }
+  for(auto &t: threads) t.join();
+  for(int k= 0; k < N; ++k) REQUIRE(copies[k] == expected);
+}
+
+
+TEST_CASE("Distance transform is exact.", "[FillBiLin]") {
+  enum { R= 13, C= 17 };
+  Eigen::ArrayXX<bool> a(R, C);
+  for(int i= 0; i < R * C; ++i) a(i)= (i * 37 % 11 != 0);
+  Eigen::ArrayXXi const d  = dirichlet::impl::edt(a);
+  int                   bad= 0;
+  for(int r= 0; r < R; ++r) {
+    for(int c= 0; c < C; ++c) {
+      // Edge of array counts as false.
+      int const e   = std::min(std::min(r + 1, R - r), std::min(c + 1, C - c));
+      int       best= (a(r, c) ? e * e : 0);
+      for(int i= 0; i < R; ++i) {
+        for(int j= 0; j < C; ++j) {
+          int const dd= (r - i) * (r - i) + (c - j) * (c - j);
+          if(!a(i, j)) best= std::min(best, dd);
+        }
+      }
+      bad+= (d(r, c) != best);
+    }
+  }
+  REQUIRE(bad == 0);
+}
+
+
+TEST_CASE("Mask pyramid matches binning of arrays.", "[FillBiLin]") {
+  // Width spans several words at level zero but not at every level, and mask
+  // is padded with zeros.
+  enum { H= 45, W= 131, R= 48, C= 136, TOP= 3 };
+  Eigen::ArrayXX<bool> a= Eigen::ArrayXX<bool>::Zero(R, C);
+  std::vector<uint8_t> m(H * W);
+  std::vector<float>   m2(H * W * 2); // Every other value is pixel.
+  uint8_t const        v[]= {1, 2, 127, 128, 255};
+  for(int r= 0; r < H; ++r) {
+    for(int c= 0; c < W; ++c) {
+      int const i  = r * W + c;
+      m[i]         = (i * 37 % 11 != 0 ? v[i % 5] : 0);
+      m2[i * 2]    = m[i];
+      m2[i * 2 + 1]= 1.0f;
+      a(r, c)      = m[i];
+    }
+  }
+  dirichlet::impl::MaskPyramid const pyr(m.data(), H, W, 1, R, C, TOP);
+  dirichlet::impl::MaskPyramid const py2(m2.data(), H, W, 2, R, C, TOP);
+  REQUIRE(pyr.top() == TOP);
+  REQUIRE(pyr[0].bits == py2[0].bits);
+  // Count pixels in which bit-packed level differs from array.
+  auto const diff= [](dirichlet::impl::MaskPyramid::Level const &p,
+                      Eigen::ArrayXX<bool> const                &q) {
+    int bad= int(p.rows != q.rows() || p.cols != q.cols());
+    for(int r= 0; !bad && r < p.rows; ++r) {
+      for(int c= 0; c < p.cols; ++c) bad+= (p(r, c) != q(r, c));
+    }
+    return bad;
+  };
+  int                  bad= 0;
+  Eigen::ArrayXX<bool> lvl= a;
+  for(int L= 0; L <= TOP; ++L) {
+    Eigen::ArrayXX<bool> const v= dirichlet::impl::validSquare(lvl);
+    bad+= diff(pyr[L], lvl);
+    bad+= diff(pyr.validSquares(L), v);
+    if(L > 0) {
+      Eigen::ArrayXX<bool> const u= dirichlet::impl::unbin2x2(v);
+      bad+= diff(pyr.unbin(pyr.validSquares(L), L), u);
+    }
+    // Expression-template reads from `lvl`, so evaluate before assignment.
+    if(L < TOP) lvl= dirichlet::impl::bin2x2(lvl).eval();
+  }
+  REQUIRE(bad == 0);
+}
+
+
+TEST_CASE("Deepest placement fills hole off binning grid.", "[FillBiLin]") {
+  enum { W= 64, H= 64 };
+  std::vector<uint8_t> mask(W * H);
+  std::vector<float>   im(W * H);
+  for(int r= 0; r < H; ++r) {
+    for(int c= 0; c < W; ++c) {
+      // Hole is offset by one pixel from grid of every binning.
+      mask[r * W + c]= (r >= 9 && r < 57 && c >= 9 && c < 57);
+      im[r * W + c]  = 10.0f + 2.0f * r + 3.0f * c;
+    }
+  }
+  FillBiLin const aligned(mask.data(), W, H);
+  FillBiLin const deepest(mask.data(), W, H, 1, dirichlet::DEEPEST);
+  REQUIRE(deepest.nSquares() > 0);
+  REQUIRE(2 * deepest.coords().rows() < aligned.coords().rows());
+  std::vector<float> const old= im;
+  deepest(im.data());
+  float most= 0.0f;
+  for(int i= 0; i < W * H; ++i) most= std::max(most, std::abs(im[i] - old[i]));
+  REQUIRE(most < 1.0E-1f);
+}
+
+
+TEST_CASE("Budget of error trades unknowns for accuracy.", "[FillBiLin]") {
+  enum { W= 96, H= 96 };
+  std::vector<uint8_t> mask(W * H);
+  std::vector<float>   im(W * H);
+  for(int r= 0; r < H; ++r) {
+    for(int c= 0; c < W; ++c) {
+      int const dr   = r - 48;
+      int const dc   = c - 48;
+      mask[r * W + c]= (dr * dr + dc * dc < 40 * 40);
+      im[r * W + c]  = float(std::cos(3.0 * std::atan2(dr, dc)));
+    }
+  }
+  std::vector<float>    exact= im;
+  dirichlet::Fill const fill(mask.data(), W, H);
+  fill(exact.data());
+  int prev= 0;
+  for(float budget: {0.001f, 0.01f, 0.1f}) {
+    FillBiLin const f(mask.data(), W, H, 1, dirichlet::ALIGNED, budget);
+    REQUIRE(f.estimatedError() <= budget);
+    if(prev) REQUIRE(f.nUnknowns() <= prev);
+    prev= f.nUnknowns();
+    std::vector<float> approx= im;
+    f(approx.data());
+    float most= 0.0f;
+    for(int i= 0; i < W * H; ++i) {
+      most= std::max(most, std::abs(approx[i] - exact[i]));
+    }
+    // Range of boundary-values is two.
+    REQUIRE(most <= 2.0f * budget);
+  }
+  FillBiLin const loose(mask.data(), W, H);
+  REQUIRE(loose.nUnknowns() < prev);
+}
+
+
 #if 1
 TEST_CASE("Big image.", "[FillBiLin]") {
   test::Image       image= test::pgm::read("gray.pgm");
@@ -189,7 +464,11 @@ TEST_CASE("Big image.", "[FillBiLin]") {
 #if SOLVE
   cout << "time to solve: " << t2.count() << " s" << endl;
 #endif
-  test::pgm::write("central-weight.pgm", f.weights().cen().cast<int>());
+  Eigen::ArrayXXi cen= Eigen::ArrayXXi::Zero(image.rows(), image.cols());
+  for(int i= 0; i < f.coords().rows(); ++i) {
+    cen(f.coords()(i, 0), f.coords()(i, 1))= f.weights().cen()(i);
+  }
+  test::pgm::write("central-weight.pgm", cen);
   test::pgm::write("gray-bilin.pgm", image.cast<int>());
 }
 #endif
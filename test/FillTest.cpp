@@ -4,15 +4,26 @@
 
 #include "dirichlet/Fill.hpp"           // Fill
 #include "pgm.hpp"                      // read(), write, Image, drawMask()
+#include <algorithm>                    // copy, count, equal
 #include <catch2/catch_test_macros.hpp> // TEST_CASE
 #include <chrono>                       // steady_clock
+#include <cstdio>                       // remove
+#include <cstdlib>                      // rand, srand
+#include <cstring>                      // memcpy
+#include <fstream>                      // ifstream, ofstream
 #include <iostream>                     // cout, endl
+#include <iterator>                     // istreambuf_iterator
+#include <sstream>                      // ostringstream
+#include <thread>                       // thread
+#include <vector>                       // vector
 
+using dirichlet::BasicFill;
 using dirichlet::Fill;
 using Eigen::Array2i;
 using Eigen::ArrayX2i;
 using std::cout;
 using std::endl;
+using std::vector;
 
 
 uint8_t image1[]= {0,  1,  2,  3,  //
@@ -37,6 +48,74 @@ unsigned width2 = 6;
 unsigned height2= 7;
 
 
+/// Random pixel-values.  Generator is seeded anew on each call, so that every
+/// test sees same values whichever tests run before it.
+/// \param n     Number of values.
+/// \param seed  Seed for rand().
+/// \return      Values, each an integer in [0, 256).
+vector<float> randomImage(int n, unsigned seed= 1) {
+  std::srand(seed);
+  vector<float> v(n);
+  for(float &p: v) p= float(std::rand() % 256);
+  return v;
+}
+
+
+/// Mask with disk-shaped hole at center.
+/// \param w       Width  of mask.
+/// \param h       Height of mask.
+/// \param radius  Radius of hole, exclusive.
+/// \return        Row-major mask.
+vector<uint8_t> diskMask(int w, int h, int radius) {
+  vector<uint8_t> m(w * h);
+  for(int r= 0; r < h; ++r) {
+    for(int c= 0; c < w; ++c) {
+      int const dr= r - h / 2;
+      int const dc= c - w / 2;
+      if(dr * dr + dc * dc < radius * radius) m[r * w + c]= 1;
+    }
+  }
+  return m;
+}
+
+
+/// Mask with rectangular hole.
+/// \param w   Width  of mask.
+/// \param h   Height of mask.
+/// \param mr  Number of rows    above hole and below it.
+/// \param mc  Number of columns left of hole and right of it.
+/// \return    Row-major mask.
+vector<uint8_t> rectMask(int w, int h, int mr, int mc) {
+  vector<uint8_t> m(w * h);
+  for(int r= mr; r < h - mr; ++r) {
+    for(int c= mc; c < w - mc; ++c) m[r * w + c]= 1;
+  }
+  return m;
+}
+
+
+/// Require that solution by instance agree with solution by CHOLESKY over
+/// same coordinates.
+/// \param g      Instance to check.
+/// \param w      Width  of image.
+/// \param h      Height of image.
+/// \param image  Image, which is not modified.
+/// \param tol    Largest difference allowed for any pixel.
+/// \return       Solution by CHOLESKY.
+Eigen::VectorXf compareWithCholesky(Fill const          &g,
+                                    int                  w,
+                                    int                  h,
+                                    vector<float> const &image,
+                                    float                tol= 0.05f) {
+  Fill const            f(g.coords(), w, h, dirichlet::CHOLESKY);
+  Eigen::VectorXf const x= f(image.data());
+  Eigen::VectorXf const y= g(image.data());
+  REQUIRE(x.size() == g.coords().rows());
+  REQUIRE((x - y).cwiseAbs().maxCoeff() < tol);
+  return x;
+}
+
+
 TEST_CASE("Constructor produces right coordinates-map.", "[Fill]") {
   cout << "starting constructor-test" << endl;
   ArrayX2i coords(3, 2);
@@ -107,6 +186,7 @@ TEST_CASE("Constructor from mask produces right coordinates-map.", "[Fill]") {
 
 
 TEST_CASE("Function works as expected.", "[Fill]") {
+  std::srand(1);
   cout << "starting function-test" << endl;
   ArrayX2i coords(20, 2);
   int      image[42];
@@ -175,6 +255,595 @@ TEST_CASE("Constructor checks oob lo col.", "[Fill]") {
 }
 
 
+void multiChannel(bool cg) {
+  // Interleaved RGBA-image; fill RGB but leave alpha alone.
+  enum { W= 9, H= 8, S= 4, N= 3 };
+  vector<float> image= randomImage(W * H * S);
+  float const   alpha= image[(4 * W + 4) * S + 3];
+  ArrayX2i    coords(12, 2);
+  int         i= 0;
+  for(int r= 2; r < 5; ++r) {
+    for(int c= 3; c < 7; ++c) coords.row(i++)= Array2i(r, c);
+  }
+  Fill const f(coords, W, H, cg);
+  // Solve each component separately from const image.
+  Eigen::MatrixXf x1(coords.rows(), N);
+  for(int k= 0; k < N; ++k) {
+    x1.col(k)= f((float const *)image.data() + k, S);
+  }
+  // Solve all components at once, and write back.
+  Eigen::MatrixXf const x3= f(image.data(), S, N);
+  REQUIRE(x3.rows() == coords.rows());
+  REQUIRE(x3.cols() == N);
+  REQUIRE((x3 - x1).cwiseAbs().maxCoeff() < 1.0E-3f);
+  for(int j= 0; j < coords.rows(); ++j) {
+    int const p= coords(j, 0) * W + coords(j, 1);
+    for(int k= 0; k < N; ++k) REQUIRE(image[p * S + k] == x3(j, k));
+  }
+  REQUIRE(image[(4 * W + 4) * S + 3] == alpha);
+}
+
+
+TEST_CASE("Multiple components are solved together.", "[Fill]") {
+  multiChannel(false);
+  multiChannel(true);
+}
+
+
+TEST_CASE("Multigrid agrees with Cholesky.", "[Fill]") {
+  // Square holes of increasing size.  With diagonal preconditioner, number
+  // of iterations grows in proportion to side of hole; with multigrid, it
+  // should grow little.
+  int const N[]= {32, 64, 128};
+  int       amg[3], cg[3];
+  for(int k= 0; k < 3; ++k) {
+    int const             W    = N[k] + 8, H= N[k] + 6;
+    vector<float> const   image= randomImage(W * H);
+    vector<uint8_t> const mask = rectMask(W, H, 3, 4);
+    Fill const            g(mask.data(), W, H, 1, dirichlet::CG);
+    Fill const            h(mask.data(), W, H, 1, dirichlet::CG_AMG);
+    REQUIRE(compareWithCholesky(g, W, H, image).size() == N[k] * N[k]);
+    compareWithCholesky(h, W, H, image);
+    amg[k]= h.iterations();
+    cg[k] = g.iterations();
+  }
+  // Side quadruples; diagonal's count nearly does, too, but not multigrid's.
+  REQUIRE(cg[2] > 3 * cg[0]);
+  REQUIRE(amg[2] <= 2 * amg[0]);
+  REQUIRE(amg[2] * 10 < cg[2]);
+}
+
+
+TEST_CASE("Disjoint holes are solved separately.", "[Fill]") {
+  enum { W= 40, H= 30 };
+  vector<float> const image= randomImage(W * H);
+  uint8_t             mask[W * H]= {};
+  // Three rectangles and two single pixels, two of which touch diagonally.
+  for(int r= 2; r < 9; ++r) {
+    for(int c= 2; c < 12; ++c) mask[r * W + c]= 1;
+  }
+  for(int r= 12; r < 27; ++r) {
+    for(int c= 20; c < 37; ++c) mask[r * W + c]= 1;
+  }
+  for(int r= 15; r < 18; ++r) {
+    for(int c= 5; c < 9; ++c) mask[r * W + c]= 1;
+  }
+  mask[18 * W + 9]= 1;
+  mask[1 * W + 30]= 1;
+  Fill const g(mask, W, H, 1, dirichlet::CG);
+  REQUIRE(g.components() == 5);
+  auto const x= compareWithCholesky(g, W, H, image);
+  // Isolated pixel is average of its four neighbors.
+  int const   i  = g.coordsMap()(1, 30);
+  float const sum=
+        image[30] + image[W + 29] + image[W + 31] + image[2 * W + 30];
+  REQUIRE(std::abs(x(i) - sum / 4) < 1.0E-4f);
+}
+
+
+TEST_CASE("Incomplete Cholesky agrees with Cholesky.", "[Fill]") {
+  enum { W= 64, H= 56 };
+  vector<float> const   image= randomImage(W * H);
+  vector<uint8_t> const mask = diskMask(W, H, 25);
+  Fill const            g(mask.data(), W, H, 1, dirichlet::CG);
+  Fill const            h(mask.data(), W, H, 1, dirichlet::CG_ICHOL);
+  compareWithCholesky(g, W, H, image);
+  compareWithCholesky(h, W, H, image);
+  // Incomplete factor cuts iterations by more than factor of three.
+  REQUIRE(g.iterations() > 0);
+  REQUIRE(h.iterations() > 0);
+  REQUIRE(h.iterations() * 3 < g.iterations());
+}
+
+
+TEST_CASE("Matrix-free operator agrees with matrix.", "[Fill]") {
+  enum { W= 50, H= 45 };
+  vector<float> const image= randomImage(W * H);
+  // Ring-shaped hole, so that some rows have boundary on both sides.
+  uint8_t mask[W * H]= {};
+  for(int r= 0; r < H; ++r) {
+    for(int c= 0; c < W; ++c) {
+      int const d2= (r - H / 2) * (r - H / 2) + (c - W / 2) * (c - W / 2);
+      if(d2 > 5 * 5 && d2 < 20 * 20) mask[r * W + c]= 1;
+    }
+  }
+  Fill const f(mask, W, H, 1, dirichlet::CG);
+  Fill const g(mask, W, H, 1, dirichlet::CG_MATRIX_FREE);
+  REQUIRE(g.a().nonZeros() == 0);
+  dirichlet::impl::Laplacian const lap(f.lrtb());
+  Eigen::VectorXf const v= Eigen::VectorXf::Random(f.coords().rows());
+  Eigen::VectorXf const p= lap * v;
+  Eigen::VectorXf const q= f.a() * v;
+  REQUIRE((p - q).cwiseAbs().maxCoeff() < 1.0E-5f);
+  compareWithCholesky(f, W, H, image);
+  compareWithCholesky(g, W, H, image);
+}
+
+
+TEST_CASE("Vectorized Laplacian agrees with scalar code.", "[Fill]") {
+  using dirichlet::impl::Simd;
+  enum { W= 45, H= 41 };
+  // Disk-shaped hole, whose number of pixels is not multiple of sixteen.
+  vector<uint8_t> const mask= diskMask(W, H, 19);
+  Fill const            f(mask.data(), W, H, 1, dirichlet::CG);
+  int const  n= int(f.coords().rows());
+  REQUIRE(n % 16 != 0);
+  dirichlet::impl::Laplacian const lap(f.lrtb());
+  Eigen::VectorXf const            x = Eigen::VectorXf::Random(n);
+  Eigen::VectorXf const            y0= Eigen::VectorXf::Random(n);
+  // Every level that processor supports, scalar first.
+  Simd const      top= dirichlet::impl::simdSupported();
+  Eigen::VectorXf ref;
+  for(Simd s: {Simd::SCALAR, Simd::AVX2, Simd::AVX512}) {
+    if(s > top) break;
+    dirichlet::impl::setSimdLimit(s);
+    REQUIRE(dirichlet::impl::simd() == s);
+    Eigen::VectorXf y= y0;
+    lap.addProduct(-0.5f, x.data(), y.data());
+    if(s == Simd::SCALAR) ref= y;
+    REQUIRE((y - ref).cwiseAbs().maxCoeff() < 1.0E-6f);
+  }
+  dirichlet::impl::setSimdLimit(top);
+  REQUIRE((ref - (y0 - 0.5f * (f.a() * x))).cwiseAbs().maxCoeff() < 1.0E-5f);
+}
+
+
+TEST_CASE("SOR agrees with Cholesky in place.", "[Fill]") {
+  enum { W= 40, H= 36, S= 3 };
+  vector<float> image= randomImage(W * H * S);
+  uint8_t       mask[W * H]= {};
+  for(int r= 0; r < H; ++r) {
+    for(int c= 0; c < W; ++c) {
+      int const dr= r - H / 2;
+      int const dc= c - W / 2;
+      if(dr * dr + 2 * dc * dc < 15 * 15) mask[r * W + c]= 1;
+    }
+  }
+  mask[2 * W + 3]= 1; // Isolated pixel.
+  Fill const f(mask, W, H, 1, dirichlet::CHOLESKY);
+  Fill       g(mask, W, H, 1, dirichlet::SOR);
+  g.setTolerance(1.0E-6f);
+  REQUIRE(g.coords().rows() == f.coords().rows());
+  REQUIRE(g.components() == 0);
+  Eigen::MatrixXf const x= f((float const *)image.data(), S, 2);
+  Eigen::MatrixXf const y= g(image.data(), S, 2);
+  REQUIRE(g.iterations() > 1);
+  REQUIRE((x - y).cwiseAbs().maxCoeff() < 0.05f);
+  // Solution is in image.
+  for(int j= 0; j < g.coords().rows(); ++j) {
+    int const p= g.coords()(j, 0) * W + g.coords()(j, 1);
+    REQUIRE(image[p * S + 1] == y(j, 1));
+  }
+  // Const or integer image cannot be relaxed in place.
+  uint8_t gray[W * H]= {};
+  REQUIRE_THROWS(g((float const *)image.data(), S));
+  REQUIRE_THROWS(g(gray));
+}
+
+
+TEST_CASE("Saved instance loads and solves.", "[Fill]") {
+  enum { W= 30, H= 24, S= 3 };
+  std::srand(1);
+  uint8_t image[W * H * S];
+  for(int i= 0; i < W * H * S; ++i) image[i]= uint8_t(rand() % 256);
+  uint8_t mask[W * H]= {};
+  for(int r= 3; r < 10; ++r) {
+    for(int c= 4; c < 20; ++c) mask[r * W + c]= 1;
+  }
+  for(int r= 14; r < 21; ++r) {
+    for(int c= 8; c < 12; ++c) mask[r * W + c]= 1;
+  }
+  Fill const f(mask, W, H, 1, dirichlet::CHOLESKY);
+  f.save("fill.bin");
+  Fill const g(std::string("fill.bin"));
+  REQUIRE(g.components() == f.components());
+  REQUIRE((g.coords() == f.coords()).all());
+  REQUIRE((g.lrtb() == f.lrtb()).all());
+  REQUIRE((g.coordsMap() == f.coordsMap()).all());
+  Eigen::MatrixXf const x= f((uint8_t const *)image, S, S);
+  Eigen::MatrixXf const y= g((uint8_t const *)image, S, S);
+  REQUIRE((x - y).cwiseAbs().maxCoeff() == 0.0f);
+  // Index out of range in any array of file is rejected.
+  std::ifstream     is("fill.bin", std::ios::binary);
+  std::vector<char> bytes((std::istreambuf_iterator<char>(is)), {});
+  is.close();
+  int const n   = int(f.coords().rows());
+  int const hdr = 36; // Bytes in header.
+  int const beg = hdr + 28 * n; // Start of offset of each component.
+  int const fac = beg + 4 * (f.components() + 1); // Start of factor.
+  int const m   = *reinterpret_cast<int const *>(&bytes[fac]);
+  int const bad[][2]= {
+        {hdr, H},                  // Row of first pixel.
+        {hdr + 4 * n, W},          // Column of first pixel.
+        {hdr + 8 * n, n},          // Left neighbor of first pixel.
+        {hdr + 8 * n, -W * H - 1}, // Left boundary-pixel of first pixel.
+        {hdr + 24 * n, n},         // First pixel of first component.
+        {beg + 4, n + 1},          // Start of second component.
+        {fac, m + 1},              // Size of first factor.
+        {fac + 16, 1 << 30},       // Offset of second column of factor.
+        {fac + 4 * (m + 4), m}};   // Row of first nonzero.
+  for(auto const &b: bad) {
+    std::vector<char> copy= bytes;
+    std::memcpy(&copy[b[0]], &b[1], sizeof(int));
+    std::ofstream os("fill.bin", std::ios::binary | std::ios::trunc);
+    os.write(copy.data(), copy.size());
+    os.close();
+    REQUIRE_THROWS(Fill(std::string("fill.bin")));
+  }
+  // In double precision, every section is aligned for double, and file is
+  // rejected by instance in single precision.
+  BasicFill<double> const fd(mask, W, H, 1, dirichlet::CHOLESKY);
+  fd.save("fill.bin");
+  BasicFill<double> const gd(std::string("fill.bin"));
+  Eigen::MatrixXd const   xd= fd((uint8_t const *)image, S, S);
+  Eigen::MatrixXd const   yd= gd((uint8_t const *)image, S, S);
+  REQUIRE((xd - yd).cwiseAbs().maxCoeff() == 0.0);
+  REQUIRE_THROWS(Fill(std::string("fill.bin")));
+  // Truncated file and file of wrong format are rejected.
+  {
+    std::ofstream os("fill.bin", std::ios::binary | std::ios::trunc);
+    os.write("DIRFILL", 8);
+  }
+  REQUIRE_THROWS(Fill(std::string("fill.bin")));
+  REQUIRE_THROWS(Fill(std::string("FillTest.cpp")));
+  std::remove("fill.bin");
+  // Only Cholesky-decomposition is saved.
+  Fill const h(mask, W, H, 1, dirichlet::CG);
+  REQUIRE_THROWS(h.save("fill.bin"));
+}
+
+
+TEST_CASE("Components of same shape share decomposition.", "[Fill]") {
+  // Draw same three shapes, translated, on canvases of different sizes.
+  auto const draw= [](vector<uint8_t> &mask, int w, int r0, int c0) {
+    for(int r= 0; r < 5; ++r) {
+      for(int c= 0; c < 7; ++c) mask[(r0 + r) * w + c0 + c]= 1;
+    }
+    for(int r= 0; r < 6; ++r) mask[(r0 + 8 + r) * w + c0]= 1;
+    for(int c= 1; c < 5; ++c) mask[(r0 + 13) * w + c0 + c]= 1;
+    mask[(r0 + 2) * w + c0 + 12]= 1;
+  };
+  enum { W1= 40, H1= 30, W2= 64, H2= 50 };
+  vector<uint8_t> mask1(W1 * H1), mask2(W2 * H2);
+  draw(mask1, W1, 2, 3);
+  draw(mask1, W1, 8, 22);
+  draw(mask2, W2, 30, 40);
+  dirichlet::FactorCache cache;
+  Fill const f(mask1.data(), W1, H1, 1, dirichlet::CHOLESKY, &cache);
+  REQUIRE(f.components() == 6);
+  // Each shape is made once, even when threads ask for it at same time.
+  REQUIRE(cache.size() == 3);
+  REQUIRE(cache.misses() == 3);
+  REQUIRE(cache.hits() == 3);
+  Fill const g(mask2.data(), W2, H2, 1, dirichlet::CHOLESKY, &cache);
+  REQUIRE(cache.size() == 3);
+  REQUIRE(cache.misses() == 3);
+  REQUIRE(cache.hits() == 6);
+  // Shared decomposition gives same answer as unshared one.
+  vector<float> const image= randomImage(W2 * H2);
+  auto const          y    = compareWithCholesky(g, W2, H2, image);
+  // Shape does not depend on order of coordinates.
+  ArrayX2i const rev= g.coords().colwise().reverse();
+  Fill const     k(rev, W2, H2, dirichlet::CHOLESKY, &cache);
+  REQUIRE(cache.misses() == 3);
+  REQUIRE(cache.hits() == 9);
+  auto const z= k((float const *)image.data());
+  REQUIRE((z - y.reverse()).cwiseAbs().maxCoeff() < 0.05f);
+}
+
+
+TEST_CASE("Cache drops least recently used shape.", "[Fill]") {
+  using Cache= dirichlet::FactorCache<float>;
+  Cache      cache(2);
+  auto const get= [&](int shape) {
+    return cache.get({shape, 0, 1}, [] { return Cache::Factor(); });
+  };
+  get(1);
+  get(2);
+  get(1);
+  get(3); // Drop 2.
+  REQUIRE(cache.size() == 2);
+  get(1);
+  get(3);
+  REQUIRE(cache.hits() == 3);
+  get(2); // Drop 1.
+  REQUIRE(cache.misses() == 4);
+  get(3);
+  get(1);
+  REQUIRE(cache.hits() == 4);
+  REQUIRE(cache.misses() == 5);
+  cache.setCapacity(1);
+  REQUIRE(cache.size() == 1);
+  REQUIRE(cache.capacity() == 1);
+  // Shape whose maker throws is not kept, so that it is made again.
+  REQUIRE_THROWS(cache.get({4, 0, 1}, []() -> Cache::Factor { throw 4; }));
+  get(4);
+  REQUIRE(cache.misses() == 7);
+  cache.clear();
+  REQUIRE(cache.size() == 0);
+}
+
+
+TEST_CASE("Domain decomposition agrees with Cholesky.", "[Fill]") {
+  enum { W= 70, H= 60 };
+  vector<float> const image= randomImage(W * H);
+  vector<uint8_t>     mask = diskMask(W, H, 27);
+  mask[3 * W + 3]          = 1;
+  Fill const g(mask.data(), W, H, 1, dirichlet::SCHUR);
+  REQUIRE(g.a().nonZeros() == 0);
+  Eigen::MatrixXf const x= compareWithCholesky(g, W, H, image, 0.01f);
+  Fill const            f(mask.data(), W, H, 1, dirichlet::CHOLESKY);
+  // Small blocks give many subdomains, long separator, and several levels of
+  // dissection.
+  dirichlet::impl::Schur const s(f.coords(), f.lrtb(), 8);
+  REQUIRE(s.subdomains() > 30);
+  REQUIRE(s.separator() > 300);
+  REQUIRE(s.levels() > 2);
+  Eigen::MatrixXf const b= f.a() * x;
+  REQUIRE((s.solve(b) - x).cwiseAbs().maxCoeff() < 0.01f);
+  // Workspace kept from solution to solution gives same answer.
+  dirichlet::impl::Schur<float>::Workspace w;
+  Eigen::MatrixXf                          z;
+  s.solve(b, z, w);
+  s.solve(Eigen::MatrixXf(2 * b), z, w);
+  REQUIRE((z - 2 * x).cwiseAbs().maxCoeff() < 0.02f);
+}
+
+
+TEST_CASE("Mixed precision reaches double precision.", "[Fill]") {
+  enum { W= 60, H= 50 };
+  vector<float> const     v= randomImage(W * H);
+  vector<double> const    image(v.begin(), v.end());
+  vector<uint8_t> const   mask= rectMask(W, H, 5, 5);
+  BasicFill<double> const d(mask.data(), W, H, 1, dirichlet::CHOLESKY);
+  BasicFill<double> const m(mask.data(), W, H, 1, dirichlet::CHOLESKY_MIXED);
+  Fill const              f(mask.data(), W, H, 1, dirichlet::CHOLESKY);
+  Eigen::VectorXd const   x = d(image.data());
+  Eigen::VectorXd const   y = m(image.data());
+  Eigen::VectorXf const   xf= f(image.data());
+  REQUIRE(m.iterations() > 0);
+  REQUIRE(m.iterations() < 10);
+  // Residual of mixed solution is at level of double precision, and far
+  // below that of single-precision solution.
+  Eigen::VectorXd const b = d.a() * x;
+  Eigen::VectorXd const xd= xf.cast<double>();
+  double const          ry= (m.a() * y - b).cwiseAbs().maxCoeff();
+  double const          rf= (d.a() * xd - b).cwiseAbs().maxCoeff();
+  REQUIRE(ry < 1.0E-9);
+  REQUIRE(ry < rf * 1.0E-3);
+  REQUIRE((x - y).cwiseAbs().maxCoeff() < 1.0E-9);
+}
+
+
+void batch(dirichlet::Method method) {
+  enum { W= 40, H= 30, N= 24 };
+  vector<uint8_t> const mask  = rectMask(W, H, 4, 5);
+  vector<float>         frames= randomImage(N * W * H);
+  vector<float>         copy  = frames;
+  vector<float *>       images(N);
+  for(int i= 0; i < N; ++i) images[i]= &frames[i * W * H];
+  Fill const f(mask.data(), W, H, 1, method);
+  f.batch(images.begin(), images.end());
+  // Each frame matches what operator() gives alone.
+  for(int i= 0; i < N; ++i) f(&copy[i * W * H]);
+  float most= 0.0f;
+  for(int p= 0; p < N * W * H; ++p) {
+    most= std::max(most, std::abs(frames[p] - copy[p]));
+  }
+  REQUIRE(most < 0.01f);
+}
+
+
+TEST_CASE("Batch agrees with one image at time.", "[Fill]") {
+  batch(dirichlet::CHOLESKY);
+  batch(dirichlet::CG);
+  batch(dirichlet::CG_MATRIX_FREE);
+  batch(dirichlet::SOR);
+}
+
+
+TEST_CASE("Bit-packed and run-length masks agree with byte-mask.", "[Fill]") {
+  enum { W= 150, H= 40, P= (W + 63) / 64 };
+  std::srand(1);
+  vector<uint8_t>        bytes(W * H);
+  vector<uint16_t>       wide(W * H);
+  vector<uint64_t>       bits(P * H);
+  vector<dirichlet::Run> runs;
+  for(int r= 0; r < H; ++r) {
+    for(int c= 0; c < W; ++c) {
+      // Sparse pixels, some runs, and pixels on edge.
+      bool const on= (rand() % 50 == 0) || (r % 7 == 3 && c > 60 && c < 140);
+      if(!on) continue;
+      bytes[r * W + c]= 1;
+      wide[r * W + c] = 1;
+      bits[r * P + c / 64]|= uint64_t(1) << (c % 64);
+      if(!runs.empty() && runs.back().row == r &&
+         runs.back().col + runs.back().length == c) {
+        ++runs.back().length;
+      } else {
+        runs.push_back({r, c, 1});
+      }
+    }
+  }
+  ArrayX2i coords(W * H, 2);
+  int      n= 0;
+  for(int r= 1; r < H - 1; ++r) {
+    for(int c= 1; c < W - 1; ++c) {
+      if(bytes[r * W + c]) coords.row(n++)= Array2i(r, c);
+    }
+  }
+  coords.conservativeResize(n, 2);
+  Fill const f(bytes.data(), W, H, 1, dirichlet::SOR);
+  Fill const g(wide.data(), W, H, 1, dirichlet::SOR);
+  Fill const b(dirichlet::BitMask{bits.data(), P}, W, H, dirichlet::SOR);
+  Fill const u(runs, W, H, dirichlet::SOR);
+  REQUIRE((f.coords() == coords).all());
+  REQUIRE((g.coords() == coords).all());
+  REQUIRE((b.coords() == coords).all());
+  REQUIRE((u.coords() == coords).all());
+}
+
+
+TEST_CASE("Vectorized mask-scan agrees with scalar code.", "[Fill]") {
+  using dirichlet::impl::Simd;
+  enum { N= 300 };
+  // Sparse bytes of various values, and one dense run.
+  std::srand(1);
+  vector<uint8_t> row(N);
+  for(int c= 0; c < N; ++c) {
+    if(rand() % 9 == 0) row[c]= uint8_t(1 + rand() % 255);
+  }
+  for(int c= 130; c < 170; ++c) row[c]= 1;
+  // Every level that processor supports, scalar first, over ranges whose
+  // ends are not aligned to any width of vector.
+  Simd const  top= dirichlet::impl::simdSupported();
+  vector<int> ref;
+  for(Simd s: {Simd::SCALAR, Simd::AVX2, Simd::AVX512}) {
+    if(s > top) break;
+    dirichlet::impl::setSimdLimit(s);
+    REQUIRE(dirichlet::impl::simd() == s);
+    vector<int> got;
+    for(int b: {0, 1, 7, 33, 65}) {
+      for(int e: {int(N), N - 1, N - 31, 200, b}) {
+        dirichlet::impl::forEachNonZero(
+              row.data(), b, e, [&](int c) { got.push_back(c); });
+        got.push_back(-1);
+      }
+    }
+    if(s == Simd::SCALAR) ref= got;
+    REQUIRE(got == ref);
+  }
+  dirichlet::impl::setSimdLimit(top);
+  REQUIRE(int(std::count(ref.begin(), ref.end(), -1)) == 25);
+  REQUIRE(ref.size() > 25 + 40);
+}
+
+
+TEST_CASE("Neighbors do not depend on order of coordinates.", "[Fill]") {
+  enum { W= 30, H= 20 };
+  ArrayX2i coords(W * H, 2);
+  int      n= 0;
+  for(int r= 2; r < H - 2; ++r) {
+    for(int c= 2; c < W - 2; ++c) {
+      if((r * c) % 5 != 0) coords.row(n++)= Array2i(r, c);
+    }
+  }
+  coords.conservativeResize(n, 2);
+  ArrayX2i const rev= coords.colwise().reverse();
+  Fill const     f(coords, W, H, dirichlet::CG);
+  Fill const     g(rev, W, H, dirichlet::CG);
+  for(int i= 0; i < n; ++i) {
+    for(int d= 0; d < 4; ++d) {
+      int const e= f.lrtb()(i, d);
+      REQUIRE(g.lrtb()(n - 1 - i, d) == (e < 0 ? e : n - 1 - e));
+    }
+  }
+  REQUIRE(f.coordsMap()(coords(7, 0), coords(7, 1)) == 7);
+}
+
+
+TEST_CASE("Threads call operator() on one instance.", "[Fill]") {
+  enum { W= 40, H= 30, N= 4 };
+  vector<uint8_t> const mask = rectMask(W, H, 4, 5);
+  vector<float> const   image= randomImage(W * H);
+  Fill const            f(mask.data(), W, H, 1, dirichlet::CG);
+  vector<float> alone= image;
+  f(alone.data());
+  int const           iters= f.iterations();
+  vector<float>       frames(N * W * H);
+  vector<std::thread> threads;
+  for(int i= 0; i < N; ++i) {
+    std::copy(image.begin(), image.end(), frames.begin() + i * W * H);
+    threads.emplace_back([&f, &frames, i] { f(&frames[i * W * H]); });
+  }
+  for(auto &t: threads) t.join();
+  // Every thread wrote same count of iterations.
+  REQUIRE(f.iterations() == iters);
+  for(int i= 0; i < N; ++i) {
+    REQUIRE(std::equal(alone.begin(), alone.end(), &frames[i * W * H]));
+  }
+}
+
+
+void view(dirichlet::Method method) {
+  // Window of RGBA-canvas, whose rows are padded; fill RGB in place.
+  enum { CW= 50, CH= 40, S= 4, P= CW * S + 6, W= 20, H= 15, R= 7, C= 11 };
+  enum { N= 3 };
+  vector<float>       canvas= randomImage(CH * P);
+  vector<float> const orig  = canvas;
+  // Same image, copied tightly.
+  vector<float> tight(W * H * S);
+  for(int r= 0; r < H; ++r) {
+    for(int k= 0; k < W * S; ++k) {
+      tight[r * W * S + k]= canvas[(R + r) * P + C * S + k];
+    }
+  }
+  uint8_t mask[W * H]= {};
+  for(int r= 3; r < H - 3; ++r) {
+    for(int c= 4; c < W - 2; ++c) mask[r * W + c]= 1;
+  }
+  Fill const            f(mask, W, H, 1, method);
+  Eigen::MatrixXf const x= f(tight.data(), S, N);
+  Eigen::MatrixXf const y= f(canvas.data(), dirichlet::View{P, S, R, C}, N);
+  REQUIRE((x - y).cwiseAbs().maxCoeff() < 1.0E-3f);
+  // Window holds filled image, and rest of canvas is untouched.
+  float most= 0.0f;
+  for(int r= 0; r < CH; ++r) {
+    for(int k= 0; k < P; ++k) {
+      int const   c = k / S;
+      bool const  in= r >= R && r < R + H && c >= C && c < C + W && k < CW * S;
+      int const   t = (r - R) * W * S + k - C * S;
+      float const v = in ? tight[t] : orig[r * P + k];
+      most          = std::max(most, std::abs(canvas[r * P + k] - v));
+    }
+  }
+  REQUIRE(most < 1.0E-3f);
+}
+
+
+TEST_CASE("View fills window of padded canvas in place.", "[Fill]") {
+  view(dirichlet::CHOLESKY);
+  view(dirichlet::CG);
+  view(dirichlet::SOR);
+}
+
+
+TEST_CASE("Stats report only sizes without macro.", "[Fill]") {
+  // Time of each phase is tested in StatsTest.cpp, which defines
+  // DIRICHLET_STATS.
+  enum { W= 40, H= 30 };
+  vector<uint8_t> const mask = rectMask(W, H, 5, 5);
+  vector<float>         image= randomImage(W * H);
+  Fill const            f(mask.data(), W, H, 1, dirichlet::CHOLESKY);
+  f(image.data());
+  dirichlet::Stats const s= f.stats();
+  REQUIRE(s.nnzA == f.a().nonZeros());
+  REQUIRE(s.nnzFactor > 0);
+  REQUIRE(s.calls[dirichlet::SOLVE] == 0);
+  REQUIRE(s.nanos[dirichlet::FACTOR] == 0);
+}
+
+
 void timing(test::Image &image, test::Image const &mask, bool cg) {
   cout << "conjugate-gradient=" << cg << endl;
 
@@ -0,0 +1,52 @@
+/// \file       test/StatsTest.cpp
+/// \copyright  2022 Thomas E. Vaughan.  See terms in LICENSE.
+/// \brief      Tests for dirichlet::Stats, recorded by dirichlet::Fill.
+
+// Record time of each phase.  Defined only in this translation unit, which
+// is linked into its own executable, so that other tests measure library as
+// it is ordinarily compiled.
+#define DIRICHLET_STATS
+
+#include "dirichlet/Fill.hpp"           // Fill
+#include <catch2/catch_test_macros.hpp> // TEST_CASE
+#include <cstdint>                      // uint8_t
+#include <cstdlib>                      // rand
+#include <sstream>                      // ostringstream
+#include <string>                       // string
+#include <vector>                       // vector
+
+using dirichlet::Fill;
+using std::vector;
+
+
+TEST_CASE("Stats count phases and size of problem.", "[Stats]") {
+  enum { W= 40, H= 30 };
+  uint8_t mask[W * H]= {};
+  for(int r= 5; r < H - 5; ++r) {
+    for(int c= 5; c < W - 5; ++c) mask[r * W + c]= 1;
+  }
+  vector<float> image(W * H);
+  for(float &v: image) v= float(std::rand() % 256);
+  Fill const f(mask, W, H, 1, dirichlet::CHOLESKY);
+  f(image.data());
+  f(image.data());
+  dirichlet::Stats const s= f.stats();
+  REQUIRE(s.nnzA == f.a().nonZeros());
+  REQUIRE(s.nnzFactor > 0);
+  REQUIRE(s.calls[dirichlet::SCAN] == 1);
+  REQUIRE(s.calls[dirichlet::FACTOR] == 1);
+  REQUIRE(s.calls[dirichlet::GATHER] == 2);
+  REQUIRE(s.calls[dirichlet::SOLVE] == 2);
+  REQUIRE(s.calls[dirichlet::WRITE_BACK] == 2);
+  REQUIRE(s.nanos[dirichlet::FACTOR] > 0);
+  Fill const g(mask, W, H, 1, dirichlet::CG);
+  g(image.data());
+  REQUIRE(g.stats().iterations == g.iterations());
+  REQUIRE(g.stats().residual < 1.0E-3);
+  std::ostringstream os;
+  f.trace(os);
+  REQUIRE(os.str().find("\"name\":\"factor\"") != std::string::npos);
+}
+
+
+// EOF
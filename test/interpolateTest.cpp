@@ -35,4 +35,15 @@ TEST_CASE("interpolate() rounds properly.", "[interpolate]") {
 }
 
 
+TEST_CASE("interpolate() rounds into narrow type.", "[interpolate]") {
+  Array22<float> crn;
+  crn << -0.5f, +1.5f, +3.5f, +5.5f;
+  ArrayXX<uint8_t> cen(2, 2);
+  interpolate(crn, cen);
+  ArrayXX<uint8_t> truth(2, 2);
+  truth << 1, 2, 3, 4;
+  REQUIRE((cen == truth).cast<int>().sum() == 4);
+}
+
+
 // EOF